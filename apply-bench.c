@@ -0,0 +1,121 @@
+/* Copyright (C) 2011, 2012 Matthias Vogelgesang <matthias.vogelgesang@kit.edu>
+   (Karlsruhe Institute of Technology)
+
+   This library is free software; you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by the
+   Free Software Foundation; either version 2.1 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+   details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with this library; if not, write to the Free Software Foundation, Inc., 51
+   Franklin St, Fifth Floor, Boston, MA 02110, USA */
+
+/*
+ * Times egg_curve_apply_buffer() on one thread and on all processors for
+ * each sample format. The image size in megapixels can be passed as the only
+ * argument.
+ */
+
+#include <stdlib.h>
+#include <gtk/gtk.h>
+#include "egg-data-points.h"
+#include "egg-curve-apply.h"
+
+#define N_CHANNELS  3
+
+static const gchar *format_names[] = { "u8", "u16", "f32" };
+static const gsize  sample_sizes[] = { 1, 2, 4 };
+
+static void
+fill_buffer (gpointer data, EggSampleFormat format, gsize n)
+{
+    guint32 seed = 1;
+
+    for (gsize i = 0; i < n; i++) {
+        seed = seed * 1664525 + 1013904223;
+
+        switch (format) {
+            case EGG_SAMPLE_FORMAT_U8:
+                ((guint8 *) data)[i] = seed >> 24;
+                break;
+            case EGG_SAMPLE_FORMAT_U16:
+                ((guint16 *) data)[i] = seed >> 16;
+                break;
+            case EGG_SAMPLE_FORMAT_F32:
+                ((gfloat *) data)[i] = (seed >> 8) / 16777216.0f;
+                break;
+        }
+    }
+}
+
+static gdouble
+time_apply (EggDataPoints **curves, gpointer data, EggSampleFormat format,
+            guint width, guint height, guint n_threads)
+{
+    gint64 start;
+
+    start = g_get_monotonic_time ();
+    egg_curve_apply_buffer (curves, data, format, width, height,
+                            width * N_CHANNELS * sample_sizes[format],
+                            N_CHANNELS, n_threads);
+
+    return (g_get_monotonic_time () - start) / 1000.0;
+}
+
+int
+main (int argc, char* argv[])
+{
+    EggDataPoints *points;
+    EggDataPoints *curves[N_CHANNELS];
+    gdouble megapixels = 24.0;
+    guint width, height;
+
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+    g_type_init ();
+#endif
+
+    if (argc > 1)
+        megapixels = atof (argv[1]);
+
+    width  = 4000;
+    height = MAX (1, (guint) (megapixels * 1e6 / width));
+
+    points = egg_data_points_new (0.0, 1.0, 0.0, 1.0);
+    egg_data_points_add_point (points, 0.0, 0.0, 1.0);
+    egg_data_points_add_point (points, 0.25, 0.4, 1.0);
+    egg_data_points_add_point (points, 0.75, 0.8, 1.0);
+    egg_data_points_add_point (points, 1.0, 1.0, 1.0);
+
+    for (guint c = 0; c < N_CHANNELS; c++)
+        curves[c] = points;
+
+    g_print ("%u x %u pixels, %u channels, %u processors\n",
+             width, height, N_CHANNELS, g_get_num_processors ());
+
+    for (EggSampleFormat format = EGG_SAMPLE_FORMAT_U8; format <= EGG_SAMPLE_FORMAT_F32; format++) {
+        gsize n = (gsize) width * height * N_CHANNELS;
+        gpointer data = g_malloc (n * sample_sizes[format]);
+        gdouble single, all;
+
+        fill_buffer (data, format, n);
+
+        /* The first run bakes the lookup tables and faults in the pages */
+        time_apply (curves, data, format, width, height, 0);
+
+        single = time_apply (curves, data, format, width, height, 1);
+        all    = time_apply (curves, data, format, width, height, 0);
+
+        g_print ("%-3s  1 thread %8.1f ms  all threads %8.1f ms  speedup %.2f\n",
+                 format_names[format], single, all, single / all);
+
+        g_free (data);
+    }
+
+    g_object_unref (points);
+    return 0;
+}
@@ -0,0 +1,226 @@
+/* Copyright (C) 2011, 2012 Matthias Vogelgesang <matthias.vogelgesang@kit.edu>
+   (Karlsruhe Institute of Technology)
+
+   This library is free software; you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by the
+   Free Software Foundation; either version 2.1 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+   details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with this library; if not, write to the Free Software Foundation, Inc., 51
+   Franklin St, Fifth Floor, Boston, MA 02110, USA */
+
+/*
+ * Applying curves to images. The curves are baked into lookup tables on the
+ * calling thread, then the image is cut into bands of rows that fit into the
+ * cache and the bands are mapped in parallel with egg_parallel_run().
+ */
+
+#include <string.h>
+#include "egg-curve-apply.h"
+#include "egg-curve-kernels.h"
+#include "egg-parallel.h"
+
+#define MAX_CHANNELS    4
+#define TILE_BYTES      (256 * 1024)
+#define F32_TABLE_SIZE  65536
+
+typedef struct
+{
+    guint8          *data;
+    EggSampleFormat  format;
+    guint            width;
+    guint            height;
+    gsize            rowstride;
+    guint            n_channels;
+
+    gpointer         table;
+    guint            passthrough;
+
+    guint            rows_per_tile;
+} ApplyJob;
+
+static void
+process_tile (gpointer data, guint tile)
+{
+    ApplyJob *job = data;
+    gsize n = (gsize) job->width * job->n_channels;
+    guint first = tile * job->rows_per_tile;
+    guint last  = MIN (first + job->rows_per_tile, job->height);
+
+    for (guint row = first; row < last; row++) {
+        gpointer line = job->data + row * job->rowstride;
+
+        switch (job->format) {
+            case EGG_SAMPLE_FORMAT_U8:
+                egg_curve_kernel_map_u8 (line, n, job->n_channels, job->table);
+                break;
+            case EGG_SAMPLE_FORMAT_U16:
+                egg_curve_kernel_map_u16 (line, n, job->n_channels, job->table);
+                break;
+            case EGG_SAMPLE_FORMAT_F32:
+                egg_curve_kernel_map_f32 (line, n, job->n_channels, job->table,
+                                          F32_TABLE_SIZE, job->passthrough);
+                break;
+        }
+    }
+}
+
+/*
+ * Concatenate the per-channel tables. Channels without a curve get an
+ * identity table for the integer formats and a passthrough bit for floats.
+ */
+static gpointer
+build_table (EggDataPoints **curves, guint n_channels, EggSampleFormat format, guint *passthrough)
+{
+    *passthrough = 0;
+
+    switch (format) {
+        case EGG_SAMPLE_FORMAT_U8:
+            {
+                guint8 *table = g_new (guint8, n_channels * 256);
+
+                for (guint c = 0; c < n_channels; c++) {
+                    if (curves[c] != NULL)
+                        memcpy (table + c * 256, egg_data_points_bake_lut_u8 (curves[c]), 256);
+                    else
+                        for (guint i = 0; i < 256; i++)
+                            table[c * 256 + i] = i;
+                }
+
+                return table;
+            }
+        case EGG_SAMPLE_FORMAT_U16:
+            {
+                guint16 *table = g_new0 (guint16, n_channels * 65536 + 1);
+
+                for (guint c = 0; c < n_channels; c++) {
+                    if (curves[c] != NULL)
+                        memcpy (table + c * 65536, egg_data_points_bake_lut_u16 (curves[c]),
+                                65536 * sizeof (guint16));
+                    else
+                        for (guint i = 0; i < 65536; i++)
+                            table[c * 65536 + i] = i;
+                }
+
+                return table;
+            }
+        case EGG_SAMPLE_FORMAT_F32:
+            {
+                gfloat *table = g_new0 (gfloat, n_channels * F32_TABLE_SIZE);
+
+                for (guint c = 0; c < n_channels; c++) {
+                    if (curves[c] != NULL)
+                        memcpy (table + c * F32_TABLE_SIZE,
+                                egg_data_points_bake_lut_float (curves[c], F32_TABLE_SIZE),
+                                F32_TABLE_SIZE * sizeof (gfloat));
+                    else
+                        *passthrough |= 1 << c;
+                }
+
+                return table;
+            }
+    }
+
+    return NULL;
+}
+
+/**
+ * egg_curve_apply_buffer:
+ * @curves: one curve per channel, %NULL leaves a channel untouched
+ * @data: interleaved image data that is modified in place
+ * @format: sample format of @data
+ * @rowstride: distance between rows in bytes
+ * @n_channels: number of interleaved channels, at most four
+ * @n_threads: number of threads to use, 0 to use all processors
+ *
+ * Map an image through per-channel curves. Integer samples cover the x range
+ * of a curve from 0 to their maximum value, float samples from 0.0 to 1.0.
+ * Results are scaled the same way from the y range.
+ *
+ * The curves must not be modified while this function runs.
+ */
+void
+egg_curve_apply_buffer (EggDataPoints    **curves,
+                        gpointer           data,
+                        EggSampleFormat    format,
+                        guint              width,
+                        guint              height,
+                        gsize              rowstride,
+                        guint              n_channels,
+                        guint              n_threads)
+{
+    ApplyJob job;
+    gsize    bytes_per_row;
+    guint    n_tiles;
+
+    g_return_if_fail (curves != NULL);
+    g_return_if_fail (data != NULL);
+    g_return_if_fail (n_channels > 0 && n_channels <= MAX_CHANNELS);
+
+    if (width == 0 || height == 0)
+        return;
+
+    bytes_per_row = rowstride > 0 ? rowstride : 1;
+
+    job.data = data;
+    job.format = format;
+    job.width = width;
+    job.height = height;
+    job.rowstride = rowstride;
+    job.n_channels = n_channels;
+    job.table = build_table (curves, n_channels, format, &job.passthrough);
+    job.rows_per_tile = MAX (1, TILE_BYTES / bytes_per_row);
+    n_tiles = (height + job.rows_per_tile - 1) / job.rows_per_tile;
+
+    egg_parallel_run (process_tile, &job, n_tiles, n_threads);
+    g_free (job.table);
+}
+
+/**
+ * egg_curve_apply_pixbuf:
+ * @curves: either a single curve for all color channels or one curve per
+ * channel of @pixbuf, where %NULL leaves a channel untouched
+ * @n_curves: number of entries in @curves
+ * @n_threads: number of threads to use, 0 to use all processors
+ *
+ * Map the pixels of an 8-bit @pixbuf in place through @curves. With a single
+ * curve the alpha channel is left untouched.
+ */
+void
+egg_curve_apply_pixbuf (GdkPixbuf        *pixbuf,
+                        EggDataPoints   **curves,
+                        guint             n_curves,
+                        guint             n_threads)
+{
+    EggDataPoints *per_channel[MAX_CHANNELS] = { NULL, };
+    guint n_channels;
+
+    g_return_if_fail (GDK_IS_PIXBUF (pixbuf));
+    g_return_if_fail (gdk_pixbuf_get_bits_per_sample (pixbuf) == 8);
+
+    n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+    g_return_if_fail (n_curves == 1 || n_curves == n_channels);
+    g_return_if_fail (n_channels <= MAX_CHANNELS);
+
+    for (guint c = 0; c < n_channels; c++) {
+        if (n_curves == 1)
+            per_channel[c] = gdk_pixbuf_get_has_alpha (pixbuf) && c == n_channels - 1 ? NULL : curves[0];
+        else
+            per_channel[c] = curves[c];
+    }
+
+    egg_curve_apply_buffer (per_channel,
+                            gdk_pixbuf_get_pixels (pixbuf),
+                            EGG_SAMPLE_FORMAT_U8,
+                            gdk_pixbuf_get_width (pixbuf),
+                            gdk_pixbuf_get_height (pixbuf),
+                            gdk_pixbuf_get_rowstride (pixbuf),
+                            n_channels,
+                            n_threads);
+}
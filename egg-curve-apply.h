@@ -0,0 +1,48 @@
+/* Copyright (C) 2011, 2012 Matthias Vogelgesang <matthias.vogelgesang@kit.edu>
+   (Karlsruhe Institute of Technology)
+
+   This library is free software; you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by the
+   Free Software Foundation; either version 2.1 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+   details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with this library; if not, write to the Free Software Foundation, Inc., 51
+   Franklin St, Fifth Floor, Boston, MA 02110, USA */
+
+#ifndef EGG_CURVE_APPLY_H
+#define EGG_CURVE_APPLY_H
+
+#include <gtk/gtk.h>
+#include "egg-data-points.h"
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+    EGG_SAMPLE_FORMAT_U8,
+    EGG_SAMPLE_FORMAT_U16,
+    EGG_SAMPLE_FORMAT_F32
+} EggSampleFormat;
+
+void    egg_curve_apply_buffer  (EggDataPoints    **curves,
+                                 gpointer           data,
+                                 EggSampleFormat    format,
+                                 guint              width,
+                                 guint              height,
+                                 gsize              rowstride,
+                                 guint              n_channels,
+                                 guint              n_threads);
+void    egg_curve_apply_pixbuf  (GdkPixbuf         *pixbuf,
+                                 EggDataPoints    **curves,
+                                 guint              n_curves,
+                                 guint              n_threads);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,481 @@
+/* Copyright (C) 2011, 2012 Matthias Vogelgesang <matthias.vogelgesang@kit.edu>
+   (Karlsruhe Institute of Technology)
+
+   This library is free software; you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by the
+   Free Software Foundation; either version 2.1 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+   details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with this library; if not, write to the Free Software Foundation, Inc., 51
+   Franklin St, Fifth Floor, Boston, MA 02110, USA */
+
+/*
+ * Inner loops of curve evaluation. Each kernel has a scalar version and, on
+ * x86 with GCC-compatible compilers, SSE2 and AVX2 versions that are picked
+ * once at runtime depending on what the CPU supports.
+ */
+
+#include "egg-curve-kernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+typedef void (*LinearKernel) (const gdouble *in, gdouble *out, gsize n, gdouble x0, gdouble y0, gdouble slope);
+typedef void (*MapU16Kernel) (guint16 *data, gsize n, guint n_channels, const guint16 *table);
+typedef void (*MapF32Kernel) (gfloat *data, gsize n, guint n_channels, const gfloat *table, guint table_size, guint passthrough);
+typedef gsize (*RunKernel) (const gdouble *in, gdouble *out, gsize n, gdouble left, gdouble right, gdouble y0, gdouble slope);
+
+static void
+linear_scalar (const gdouble *in, gdouble *out, gsize n, gdouble x0, gdouble y0, gdouble slope)
+{
+    for (gsize i = 0; i < n; i++)
+        out[i] = y0 + (in[i] - x0) * slope;
+}
+
+static gsize
+run_scalar (const gdouble *in, gdouble *out, gsize n, gdouble left, gdouble right, gdouble y0, gdouble slope)
+{
+    gsize i;
+
+    for (i = 0; i < n && in[i] >= left && in[i] < right; i++)
+        out[i] = y0 + (in[i] - left) * slope;
+
+    return i;
+}
+
+static void
+map_u16_scalar (guint16 *data, gsize n, guint n_channels, const guint16 *table)
+{
+    for (gsize i = 0; i < n; i += n_channels) {
+        for (guint c = 0; c < n_channels && i + c < n; c++)
+            data[i + c] = table[c * 65536 + data[i + c]];
+    }
+}
+
+static inline guint
+f32_to_index (gfloat v, guint table_size)
+{
+    /* Written so that NaN ends up at zero */
+    v = v > 0.0f ? v : 0.0f;
+    v = v < 1.0f ? v : 1.0f;
+    return (guint) (v * (table_size - 1) + 0.5f);
+}
+
+static void
+map_f32_scalar (gfloat *data, gsize n, guint n_channels, const gfloat *table, guint table_size, guint passthrough)
+{
+    for (gsize i = 0; i < n; i += n_channels) {
+        for (guint c = 0; c < n_channels && i + c < n; c++) {
+            if (!(passthrough & (1 << c)))
+                data[i + c] = table[c * table_size + f32_to_index (data[i + c], table_size)];
+        }
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+/*
+ * The gather kernels look up all channels at once in tables that are laid out
+ * one channel after the other. Lane l of a vector starting at element e
+ * belongs to channel (e + l) % n_channels, so there are n_channels different
+ * offset patterns that are prepared up front.
+ */
+__attribute__((target("avx2")))
+static void
+channel_offsets (__m256i *offsets, guint n_channels, guint table_size)
+{
+    for (guint phase = 0; phase < n_channels; phase++) {
+        gint32 lanes[8];
+
+        for (guint l = 0; l < 8; l++)
+            lanes[l] = ((phase + l) % n_channels) * table_size;
+
+        offsets[phase] = _mm256_loadu_si256 ((const __m256i *) lanes);
+    }
+}
+
+__attribute__((target("avx2")))
+static void
+map_u16_avx2 (guint16 *data, gsize n, guint n_channels, const guint16 *table)
+{
+    __m256i offsets[4];
+    __m256i low = _mm256_set1_epi32 (0xffff);
+    guint phase = 0;
+    gsize i = 0;
+
+    channel_offsets (offsets, n_channels, 65536);
+
+    /* Each gather reads 32 bits, the table carries one entry of padding */
+    for (; i + 8 <= n; i += 8) {
+        __m256i idx = _mm256_cvtepu16_epi32 (_mm_loadu_si128 ((const __m128i *) (data + i)));
+        __m256i v = _mm256_i32gather_epi32 ((const int *) table, _mm256_add_epi32 (idx, offsets[phase]), 2);
+
+        v = _mm256_and_si256 (v, low);
+        v = _mm256_permute4x64_epi64 (_mm256_packus_epi32 (v, v), 0x08);
+        _mm_storeu_si128 ((__m128i *) (data + i), _mm256_castsi256_si128 (v));
+        phase = (phase + 8) % n_channels;
+    }
+
+    for (; i < n; i++)
+        data[i] = table[((i % n_channels) * 65536) + data[i]];
+}
+
+__attribute__((target("avx2")))
+static void
+map_f32_avx2 (gfloat *data, gsize n, guint n_channels, const gfloat *table, guint table_size, guint passthrough)
+{
+    __m256i offsets[4];
+    __m256  keep[4];
+    __m256  zero  = _mm256_setzero_ps ();
+    __m256  one   = _mm256_set1_ps (1.0f);
+    __m256  scale = _mm256_set1_ps (table_size - 1);
+    __m256  half  = _mm256_set1_ps (0.5f);
+    guint phase = 0;
+    gsize i = 0;
+
+    channel_offsets (offsets, n_channels, table_size);
+
+    for (guint p = 0; p < n_channels; p++) {
+        gint32 lanes[8];
+
+        for (guint l = 0; l < 8; l++)
+            lanes[l] = (passthrough & (1 << ((p + l) % n_channels))) ? -1 : 0;
+
+        keep[p] = _mm256_castsi256_ps (_mm256_loadu_si256 ((const __m256i *) lanes));
+    }
+
+    for (; i + 8 <= n; i += 8) {
+        __m256  x = _mm256_loadu_ps (data + i);
+        __m256  c = _mm256_min_ps (_mm256_max_ps (x, zero), one);
+        __m256i idx = _mm256_cvttps_epi32 (_mm256_add_ps (_mm256_mul_ps (c, scale), half));
+        __m256  v = _mm256_i32gather_ps (table, _mm256_add_epi32 (idx, offsets[phase]), 4);
+
+        _mm256_storeu_ps (data + i, _mm256_blendv_ps (v, x, keep[phase]));
+        phase = (phase + 8) % n_channels;
+    }
+
+    for (; i < n; i++) {
+        guint c = i % n_channels;
+
+        if (!(passthrough & (1 << c)))
+            data[i] = table[c * table_size + f32_to_index (data[i], table_size)];
+    }
+}
+
+__attribute__((target("sse2")))
+static gsize
+run_sse2 (const gdouble *in, gdouble *out, gsize n, gdouble left, gdouble right, gdouble y0, gdouble slope)
+{
+    __m128d vl = _mm_set1_pd (left);
+    __m128d vr = _mm_set1_pd (right);
+    __m128d vy = _mm_set1_pd (y0);
+    __m128d vs = _mm_set1_pd (slope);
+    gsize i = 0;
+
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = _mm_loadu_pd (in + i);
+        __m128d inside = _mm_and_pd (_mm_cmpge_pd (x, vl), _mm_cmplt_pd (x, vr));
+
+        if (_mm_movemask_pd (inside) != 0x3)
+            break;
+
+        _mm_storeu_pd (out + i, _mm_add_pd (vy, _mm_mul_pd (_mm_sub_pd (x, vl), vs)));
+    }
+
+    return i + run_scalar (in + i, out + i, n - i, left, right, y0, slope);
+}
+
+__attribute__((target("avx2")))
+static gsize
+run_avx2 (const gdouble *in, gdouble *out, gsize n, gdouble left, gdouble right, gdouble y0, gdouble slope)
+{
+    __m256d vl = _mm256_set1_pd (left);
+    __m256d vr = _mm256_set1_pd (right);
+    __m256d vy = _mm256_set1_pd (y0);
+    __m256d vs = _mm256_set1_pd (slope);
+    gsize i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd (in + i);
+        __m256d inside = _mm256_and_pd (_mm256_cmp_pd (x, vl, _CMP_GE_OQ),
+                                        _mm256_cmp_pd (x, vr, _CMP_LT_OQ));
+
+        if (_mm256_movemask_pd (inside) != 0xf)
+            break;
+
+        _mm256_storeu_pd (out + i, _mm256_add_pd (vy, _mm256_mul_pd (_mm256_sub_pd (x, vl), vs)));
+    }
+
+    return i + run_scalar (in + i, out + i, n - i, left, right, y0, slope);
+}
+
+__attribute__((target("sse2")))
+static void
+linear_sse2 (const gdouble *in, gdouble *out, gsize n, gdouble x0, gdouble y0, gdouble slope)
+{
+    __m128d vx = _mm_set1_pd (x0);
+    __m128d vy = _mm_set1_pd (y0);
+    __m128d vs = _mm_set1_pd (slope);
+    gsize i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128d a = _mm_sub_pd (_mm_loadu_pd (in + i), vx);
+        __m128d b = _mm_sub_pd (_mm_loadu_pd (in + i + 2), vx);
+        _mm_storeu_pd (out + i, _mm_add_pd (vy, _mm_mul_pd (a, vs)));
+        _mm_storeu_pd (out + i + 2, _mm_add_pd (vy, _mm_mul_pd (b, vs)));
+    }
+
+    linear_scalar (in + i, out + i, n - i, x0, y0, slope);
+}
+
+__attribute__((target("avx2")))
+static void
+linear_avx2 (const gdouble *in, gdouble *out, gsize n, gdouble x0, gdouble y0, gdouble slope)
+{
+    __m256d vx = _mm256_set1_pd (x0);
+    __m256d vy = _mm256_set1_pd (y0);
+    __m256d vs = _mm256_set1_pd (slope);
+    gsize i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256d a = _mm256_sub_pd (_mm256_loadu_pd (in + i), vx);
+        __m256d b = _mm256_sub_pd (_mm256_loadu_pd (in + i + 4), vx);
+        _mm256_storeu_pd (out + i, _mm256_add_pd (vy, _mm256_mul_pd (a, vs)));
+        _mm256_storeu_pd (out + i + 4, _mm256_add_pd (vy, _mm256_mul_pd (b, vs)));
+    }
+
+    linear_scalar (in + i, out + i, n - i, x0, y0, slope);
+}
+#endif
+
+static LinearKernel
+select_linear_kernel (void)
+{
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init ();
+
+    if (__builtin_cpu_supports ("avx2"))
+        return linear_avx2;
+
+    if (__builtin_cpu_supports ("sse2"))
+        return linear_sse2;
+#endif
+
+    return linear_scalar;
+}
+
+static MapU16Kernel
+select_map_u16_kernel (void)
+{
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init ();
+
+    if (__builtin_cpu_supports ("avx2"))
+        return map_u16_avx2;
+#endif
+
+    return map_u16_scalar;
+}
+
+static MapF32Kernel
+select_map_f32_kernel (void)
+{
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init ();
+
+    if (__builtin_cpu_supports ("avx2"))
+        return map_f32_avx2;
+#endif
+
+    return map_f32_scalar;
+}
+
+static RunKernel
+select_run_kernel (void)
+{
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init ();
+
+    if (__builtin_cpu_supports ("avx2"))
+        return run_avx2;
+
+    if (__builtin_cpu_supports ("sse2"))
+        return run_sse2;
+#endif
+
+    return run_scalar;
+}
+
+/**
+ * egg_curve_kernel_linear:
+ *
+ * Compute out[i] = y0 + (in[i] - x0) * slope for @n values. @in and @out may
+ * be the same array.
+ */
+void
+egg_curve_kernel_linear (const gdouble *in,
+                         gdouble       *out,
+                         gsize          n,
+                         gdouble        x0,
+                         gdouble        y0,
+                         gdouble        slope)
+{
+    static gsize kernel = 0;
+
+    if (g_once_init_enter (&kernel))
+        g_once_init_leave (&kernel, (gsize) select_linear_kernel ());
+
+    ((LinearKernel) kernel) (in, out, n, x0, y0, slope);
+}
+
+/**
+ * egg_curve_kernel_linear_run:
+ *
+ * Compute out[i] = y0 + (in[i] - left) * slope for the leading inputs that lie
+ * within [@left, @right) and stop at the first one that does not.
+ *
+ * Returns: the number of values written.
+ */
+gsize
+egg_curve_kernel_linear_run (const gdouble *in,
+                             gdouble       *out,
+                             gsize          n,
+                             gdouble        left,
+                             gdouble        right,
+                             gdouble        y0,
+                             gdouble        slope)
+{
+    static gsize kernel = 0;
+
+    if (g_once_init_enter (&kernel))
+        g_once_init_leave (&kernel, (gsize) select_run_kernel ());
+
+    return ((RunKernel) kernel) (in, out, n, left, right, y0, slope);
+}
+
+void
+egg_curve_kernel_fill (gdouble *out,
+                       gsize    n,
+                       gdouble  value)
+{
+    for (gsize i = 0; i < n; i++)
+        out[i] = value;
+}
+
+/**
+ * egg_curve_kernel_lower_bound:
+ *
+ * Returns: the index of the first of the @n ascending values in @xs that is
+ * not less than @x, or @n if there is none.
+ */
+guint
+egg_curve_kernel_lower_bound (const gdouble *xs,
+                              guint          n,
+                              gdouble        x)
+{
+    guint lower = 0;
+    guint upper = n;
+
+    while (lower < upper) {
+        guint mid = lower + (upper - lower) / 2;
+
+        if (xs[mid] < x)
+            lower = mid + 1;
+        else
+            upper = mid;
+    }
+
+    return lower;
+}
+
+/**
+ * egg_curve_kernel_map_u8:
+ *
+ * Map @n interleaved 8-bit samples through @table, which holds 256 entries
+ * for each of the @n_channels channels. Byte tables are small enough that a
+ * scalar lookup beats a vector gather, so there is only one version.
+ */
+void
+egg_curve_kernel_map_u8 (guint8       *data,
+                         gsize         n,
+                         guint         n_channels,
+                         const guint8 *table)
+{
+    gsize i = 0;
+
+    switch (n_channels) {
+        case 1:
+            for (; i < n; i++)
+                data[i] = table[data[i]];
+            break;
+        case 3:
+            for (; i + 3 <= n; i += 3) {
+                data[i]     = table[data[i]];
+                data[i + 1] = table[256 + data[i + 1]];
+                data[i + 2] = table[512 + data[i + 2]];
+            }
+            break;
+        case 4:
+            for (; i + 4 <= n; i += 4) {
+                data[i]     = table[data[i]];
+                data[i + 1] = table[256 + data[i + 1]];
+                data[i + 2] = table[512 + data[i + 2]];
+                data[i + 3] = table[768 + data[i + 3]];
+            }
+            break;
+    }
+
+    for (; i < n; i++)
+        data[i] = table[(i % n_channels) * 256 + data[i]];
+}
+
+/**
+ * egg_curve_kernel_map_u16:
+ *
+ * Map @n interleaved 16-bit samples through @table, which holds 65536 entries
+ * for each of the @n_channels channels followed by one entry of padding.
+ */
+void
+egg_curve_kernel_map_u16 (guint16       *data,
+                          gsize          n,
+                          guint          n_channels,
+                          const guint16 *table)
+{
+    static gsize kernel = 0;
+
+    if (g_once_init_enter (&kernel))
+        g_once_init_leave (&kernel, (gsize) select_map_u16_kernel ());
+
+    ((MapU16Kernel) kernel) (data, n, n_channels, table);
+}
+
+/**
+ * egg_curve_kernel_map_f32:
+ *
+ * Map @n interleaved float samples in [0, 1] through @table, which holds
+ * @table_size entries for each of the @n_channels channels. Inputs are
+ * clamped and looked up at the nearest entry. Channels with their bit set in
+ * @passthrough are left untouched.
+ */
+void
+egg_curve_kernel_map_f32 (gfloat       *data,
+                          gsize         n,
+                          guint         n_channels,
+                          const gfloat *table,
+                          guint         table_size,
+                          guint         passthrough)
+{
+    static gsize kernel = 0;
+
+    if (g_once_init_enter (&kernel))
+        g_once_init_leave (&kernel, (gsize) select_map_f32_kernel ());
+
+    ((MapF32Kernel) kernel) (data, n, n_channels, table, table_size, passthrough);
+}
@@ -0,0 +1,63 @@
+/* Copyright (C) 2011, 2012 Matthias Vogelgesang <matthias.vogelgesang@kit.edu>
+   (Karlsruhe Institute of Technology)
+
+   This library is free software; you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by the
+   Free Software Foundation; either version 2.1 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+   details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with this library; if not, write to the Free Software Foundation, Inc., 51
+   Franklin St, Fifth Floor, Boston, MA 02110, USA */
+
+#ifndef EGG_CURVE_KERNELS_H
+#define EGG_CURVE_KERNELS_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+void    egg_curve_kernel_linear     (const gdouble  *in,
+                                     gdouble        *out,
+                                     gsize           n,
+                                     gdouble         x0,
+                                     gdouble         y0,
+                                     gdouble         slope);
+gsize   egg_curve_kernel_linear_run (const gdouble  *in,
+                                     gdouble        *out,
+                                     gsize           n,
+                                     gdouble         left,
+                                     gdouble         right,
+                                     gdouble         y0,
+                                     gdouble         slope);
+void    egg_curve_kernel_fill       (gdouble        *out,
+                                     gsize           n,
+                                     gdouble         value);
+guint   egg_curve_kernel_lower_bound
+                                    (const gdouble  *xs,
+                                     guint           n,
+                                     gdouble         x);
+
+void    egg_curve_kernel_map_u8     (guint8         *data,
+                                     gsize           n,
+                                     guint           n_channels,
+                                     const guint8   *table);
+void    egg_curve_kernel_map_u16    (guint16        *data,
+                                     gsize           n,
+                                     guint           n_channels,
+                                     const guint16  *table);
+void    egg_curve_kernel_map_f32    (gfloat         *data,
+                                     gsize           n,
+                                     guint           n_channels,
+                                     const gfloat   *table,
+                                     guint           table_size,
+                                     guint           passthrough);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,302 @@
+/* Copyright (C) 2011, 2012 Matthias Vogelgesang <matthias.vogelgesang@kit.edu>
+   (Karlsruhe Institute of Technology)
+
+   This library is free software; you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by the
+   Free Software Foundation; either version 2.1 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+   details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with this library; if not, write to the Free Software Foundation, Inc., 51
+   Franklin St, Fifth Floor, Boston, MA 02110, USA */
+
+/*
+ * Live preview of a curve on a downscaled copy of an image. Every change of
+ * the curve bakes a fresh lookup table on the main thread and maps the proxy
+ * image on a worker thread. A newer curve state cancels the job that is still
+ * running, and only the result of the most recent job is published.
+ */
+
+#include <string.h>
+#include "egg-curve-preview.h"
+#include "egg-curve-kernels.h"
+
+G_DEFINE_TYPE (EggCurvePreview, egg_curve_preview, G_TYPE_OBJECT)
+
+#define EGG_CURVE_PREVIEW_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE((obj), EGG_TYPE_CURVE_PREVIEW, EggCurvePreviewPrivate))
+
+/* Number of rows mapped between two checks for cancellation */
+#define CANCEL_CHECK_ROWS   32
+
+struct _EggCurvePreviewPrivate
+{
+    EggDataPoints   *points;
+    GdkPixbuf       *proxy;
+    GdkPixbuf       *result;
+    GCancellable    *cancellable;
+    guint            serial;
+};
+
+typedef struct
+{
+    GdkPixbuf   *proxy;
+    guint8       table[4 * 256];
+    guint        serial;
+} PreviewJob;
+
+enum
+{
+    UPDATED,
+    LAST_SIGNAL
+};
+
+static guint egg_curve_preview_signals[LAST_SIGNAL] = { 0 };
+
+static void schedule_update (EggCurvePreview *preview);
+
+static void
+on_point_changed (EggDataPoints *points, guint index, EggCurvePreview *preview)
+{
+    schedule_update (preview);
+}
+
+static void
+on_points_changed (EggDataPoints *points, guint first, guint last, EggCurvePreview *preview)
+{
+    schedule_update (preview);
+}
+
+/**
+ * egg_curve_preview_new:
+ * @points: curve to preview
+ * @source: image the curve is applied to
+ * @max_size: maximum width and height of the preview image
+ *
+ * Create a preview that follows all changes of @points. Connect to the
+ * "updated" signal to be notified about new preview images.
+ */
+EggCurvePreview *
+egg_curve_preview_new (EggDataPoints *points,
+                       GdkPixbuf     *source,
+                       gint           max_size)
+{
+    EggCurvePreview *preview;
+    EggCurvePreviewPrivate *priv;
+    gint width, height;
+
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (points), NULL);
+    g_return_val_if_fail (GDK_IS_PIXBUF (source), NULL);
+    g_return_val_if_fail (gdk_pixbuf_get_bits_per_sample (source) == 8, NULL);
+    g_return_val_if_fail (max_size > 0, NULL);
+
+    preview = EGG_CURVE_PREVIEW (g_object_new (EGG_TYPE_CURVE_PREVIEW, NULL));
+    priv = preview->priv;
+
+    width  = gdk_pixbuf_get_width (source);
+    height = gdk_pixbuf_get_height (source);
+
+    if (width > max_size || height > max_size) {
+        gdouble scale = (gdouble) max_size / MAX (width, height);
+
+        priv->proxy = gdk_pixbuf_scale_simple (source,
+                                               MAX (1, (gint) (width * scale)),
+                                               MAX (1, (gint) (height * scale)),
+                                               GDK_INTERP_BILINEAR);
+    }
+    else
+        priv->proxy = g_object_ref (source);
+
+    priv->points = g_object_ref (points);
+    g_signal_connect (points, "value-changed", G_CALLBACK (on_point_changed), preview);
+    g_signal_connect (points, "point-inserted", G_CALLBACK (on_point_changed), preview);
+    g_signal_connect (points, "point-removed", G_CALLBACK (on_point_changed), preview);
+    g_signal_connect (points, "points-changed", G_CALLBACK (on_points_changed), preview);
+
+    schedule_update (preview);
+
+    return preview;
+}
+
+/**
+ * egg_curve_preview_get_pixbuf:
+ *
+ * Returns: the most recent preview image or %NULL if none has been computed
+ * yet. The pixbuf is owned by @preview.
+ */
+GdkPixbuf *
+egg_curve_preview_get_pixbuf (EggCurvePreview *preview)
+{
+    g_return_val_if_fail (EGG_IS_CURVE_PREVIEW (preview), NULL);
+    return preview->priv->result;
+}
+
+static void
+free_job (PreviewJob *job)
+{
+    g_object_unref (job->proxy);
+    g_slice_free (PreviewJob, job);
+}
+
+static void
+run_job (GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+    PreviewJob *job = task_data;
+    GdkPixbuf *result;
+    guint8 *pixels;
+    gsize rowstride;
+    gint width, height, n_channels;
+
+    result = gdk_pixbuf_copy (job->proxy);
+    pixels = gdk_pixbuf_get_pixels (result);
+    rowstride = gdk_pixbuf_get_rowstride (result);
+    width = gdk_pixbuf_get_width (result);
+    height = gdk_pixbuf_get_height (result);
+    n_channels = gdk_pixbuf_get_n_channels (result);
+
+    for (gint row = 0; row < height; row++) {
+        if (row % CANCEL_CHECK_ROWS == 0 && g_cancellable_is_cancelled (cancellable)) {
+            g_object_unref (result);
+            g_task_return_error_if_cancelled (task);
+            return;
+        }
+
+        egg_curve_kernel_map_u8 (pixels + row * rowstride, (gsize) width * n_channels,
+                                 n_channels, job->table);
+    }
+
+    g_task_return_pointer (task, result, g_object_unref);
+}
+
+static void
+on_job_done (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+    EggCurvePreview *preview = EGG_CURVE_PREVIEW (source_object);
+    EggCurvePreviewPrivate *priv = preview->priv;
+    PreviewJob *job = g_task_get_task_data (G_TASK (res));
+    GdkPixbuf *result;
+
+    result = g_task_propagate_pointer (G_TASK (res), NULL);
+
+    if (result == NULL)
+        return;
+
+    if (job->serial != priv->serial) {
+        g_object_unref (result);
+        return;
+    }
+
+    if (priv->result != NULL)
+        g_object_unref (priv->result);
+
+    priv->result = result;
+    g_signal_emit (preview, egg_curve_preview_signals[UPDATED], 0);
+}
+
+static void
+schedule_update (EggCurvePreview *preview)
+{
+    EggCurvePreviewPrivate *priv = preview->priv;
+    const guint8 *lut;
+    PreviewJob *job;
+    GTask *task;
+    gint n_channels;
+
+    if (priv->cancellable != NULL) {
+        g_cancellable_cancel (priv->cancellable);
+        g_object_unref (priv->cancellable);
+    }
+
+    priv->cancellable = g_cancellable_new ();
+    priv->serial++;
+
+    /* Snapshot the curve, the store must not be touched from the worker */
+    job = g_slice_new (PreviewJob);
+    job->proxy = g_object_ref (priv->proxy);
+    job->serial = priv->serial;
+
+    lut = egg_data_points_bake_lut_u8 (priv->points);
+    n_channels = gdk_pixbuf_get_n_channels (priv->proxy);
+
+    for (gint c = 0; c < n_channels; c++) {
+        if (gdk_pixbuf_get_has_alpha (priv->proxy) && c == n_channels - 1) {
+            for (guint i = 0; i < 256; i++)
+                job->table[c * 256 + i] = i;
+        }
+        else
+            memcpy (job->table + c * 256, lut, 256);
+    }
+
+    task = g_task_new (preview, priv->cancellable, on_job_done, NULL);
+    g_task_set_task_data (task, job, (GDestroyNotify) free_job);
+    g_task_set_return_on_cancel (task, TRUE);
+    g_task_run_in_thread (task, run_job);
+    g_object_unref (task);
+}
+
+static void
+egg_curve_preview_dispose (GObject *object)
+{
+    EggCurvePreviewPrivate *priv;
+
+    priv = EGG_CURVE_PREVIEW_GET_PRIVATE (object);
+
+    if (priv->cancellable != NULL) {
+        g_cancellable_cancel (priv->cancellable);
+        g_object_unref (priv->cancellable);
+        priv->cancellable = NULL;
+    }
+
+    if (priv->points != NULL) {
+        g_signal_handlers_disconnect_by_func (priv->points, on_point_changed, object);
+        g_signal_handlers_disconnect_by_func (priv->points, on_points_changed, object);
+        g_object_unref (priv->points);
+        priv->points = NULL;
+    }
+
+    if (priv->proxy != NULL) {
+        g_object_unref (priv->proxy);
+        priv->proxy = NULL;
+    }
+
+    if (priv->result != NULL) {
+        g_object_unref (priv->result);
+        priv->result = NULL;
+    }
+
+    G_OBJECT_CLASS (egg_curve_preview_parent_class)->dispose (object);
+}
+
+static void
+egg_curve_preview_class_init (EggCurvePreviewClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+    gobject_class->dispose = egg_curve_preview_dispose;
+
+    egg_curve_preview_signals[UPDATED] =
+        g_signal_new ("updated",
+                      G_TYPE_FROM_CLASS (klass),
+                      G_SIGNAL_RUN_LAST,
+                      G_STRUCT_OFFSET (EggCurvePreviewClass, updated),
+                      NULL, NULL,
+                      g_cclosure_marshal_VOID__VOID,
+                      G_TYPE_NONE, 0);
+
+    g_type_class_add_private (klass, sizeof (EggCurvePreviewPrivate));
+}
+
+static void
+egg_curve_preview_init (EggCurvePreview *preview)
+{
+    preview->priv = EGG_CURVE_PREVIEW_GET_PRIVATE (preview);
+    preview->priv->points = NULL;
+    preview->priv->proxy = NULL;
+    preview->priv->result = NULL;
+    preview->priv->cancellable = NULL;
+    preview->priv->serial = 0;
+}
@@ -0,0 +1,61 @@
+/* Copyright (C) 2011, 2012 Matthias Vogelgesang <matthias.vogelgesang@kit.edu>
+   (Karlsruhe Institute of Technology)
+
+   This library is free software; you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by the
+   Free Software Foundation; either version 2.1 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+   details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with this library; if not, write to the Free Software Foundation, Inc., 51
+   Franklin St, Fifth Floor, Boston, MA 02110, USA */
+
+#ifndef EGG_CURVE_PREVIEW_H
+#define EGG_CURVE_PREVIEW_H
+
+#include <gtk/gtk.h>
+#include "egg-data-points.h"
+
+G_BEGIN_DECLS
+
+#define EGG_TYPE_CURVE_PREVIEW             (egg_curve_preview_get_type())
+#define EGG_CURVE_PREVIEW(obj)             (G_TYPE_CHECK_INSTANCE_CAST((obj), EGG_TYPE_CURVE_PREVIEW, EggCurvePreview))
+#define EGG_IS_CURVE_PREVIEW(obj)          (G_TYPE_CHECK_INSTANCE_TYPE((obj), EGG_TYPE_CURVE_PREVIEW))
+#define EGG_CURVE_PREVIEW_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST((klass), EGG_TYPE_CURVE_PREVIEW, EggCurvePreviewClass))
+#define EGG_IS_CURVE_PREVIEW_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE((klass), EGG_TYPE_CURVE_PREVIEW))
+#define EGG_CURVE_PREVIEW_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS((obj), EGG_TYPE_CURVE_PREVIEW, EggCurvePreviewClass))
+
+typedef struct _EggCurvePreview           EggCurvePreview;
+typedef struct _EggCurvePreviewClass      EggCurvePreviewClass;
+typedef struct _EggCurvePreviewPrivate    EggCurvePreviewPrivate;
+
+struct _EggCurvePreview
+{
+    GObject parent_instance;
+
+    /*< private >*/
+    EggCurvePreviewPrivate *priv;
+};
+
+struct _EggCurvePreviewClass
+{
+    GObjectClass parent_class;
+
+    /* signals */
+    void (* updated)  (EggCurvePreview *preview);
+};
+
+GType             egg_curve_preview_get_type    (void);
+EggCurvePreview * egg_curve_preview_new         (EggDataPoints   *points,
+                                                 GdkPixbuf       *source,
+                                                 gint             max_size);
+GdkPixbuf       * egg_curve_preview_get_pixbuf  (EggCurvePreview *preview);
+
+G_END_DECLS
+
+#endif
@@ -17,18 +17,83 @@
 
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 #include "egg-data-points.h"
+#include "egg-kd-tree.h"
+#include "egg-curve-kernels.h"
+#include "egg-parallel.h"
 
 G_DEFINE_TYPE (EggDataPoints, egg_data_points, G_TYPE_OBJECT)
 
 #define EGG_DATA_POINTS_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE((obj), EGG_TYPE_DATA_POINTS, EggDataPointsPrivate))
 
+/* Number of change ranges remembered for egg_data_points_get_changes_since() */
+#define HISTORY_SIZE    32
+
+/* Smallest gap allocated when the storage grows */
+#define MIN_GAP_SIZE    16
+
+/* Curves with fewer points are simplified on the calling thread alone */
+#define MIN_PARALLEL_POINTS 65536
+
+typedef struct
+{
+    guint64  generation;
+    guint    first;
+    guint    last;
+    gboolean structural;
+} ChangeRange;
+
 struct _EggDataPointsPrivate
 {
     gdouble      lower_x, upper_x;
     gdouble      lower_y, upper_y;
-    GPtrArray   *x_adjustments;
-    GPtrArray   *y_adjustments;
+
+    /* Coordinates are stored packed, adjustments are only created on demand
+     * by egg_data_points_get_x() and egg_data_points_get_y() and map from the
+     * point index to the GtkAdjustment. */
+    GArray      *x_values;
+    GArray      *y_values;
+    GArray      *increments;
+
+    /* The three arrays share a gap of unused slots at gap_start, which is
+     * moved to where points are inserted or removed. Edits close to the
+     * previous one only move the elements in between. See value_location(). */
+    guint        n_points;
+    guint        gap_start;
+    guint        gap_size;
+    GHashTable  *x_adjustments;
+    GHashTable  *y_adjustments;
+
+    /* Spatial index over normalized coordinates, built on first query and
+     * dropped when points in front of others are inserted or removed */
+    EggKdTree   *tree;
+
+    /* Min/max pyramid over the y values, built on first query. Level k >= 1
+     * holds the indices of the smallest and largest value of each block of
+     * 2^k points, starting at pair extrema_offsets[k]. */
+    guint       *extrema;
+    guint        extrema_levels;
+    gsize        extrema_offsets[33];
+
+    /* Lookup tables baked on request, dropped whenever a point changes */
+    guint8      *lut_u8;
+    guint16     *lut_u16;
+    gfloat      *lut_float;
+    guint        lut_float_size;
+
+    /* Nesting depth of begin/end_update() and the points touched meanwhile */
+    guint        update_depth;
+    gboolean     dirty;
+    guint        dirty_first;
+    guint        dirty_last;
+
+    /* Ring of the most recent changes, tagged with the generation that
+     * introduced them. Anything older than history_floor is forgotten. */
+    guint64      generation;
+    guint64      history_floor;
+    ChangeRange  history[HISTORY_SIZE];
+    guint        history_head;
 };
 
 enum
@@ -41,292 +106,1929 @@ enum
     N_PROPERTIES
 };
 
-enum
+enum
+{
+    POINT_INSERTED,
+    POINT_REMOVED,
+    VALUE_CHANGED,
+    POINTS_CHANGED,
+    LAST_SIGNAL
+};
+
+static GParamSpec *egg_data_points_properties[N_PROPERTIES] = { NULL, };
+
+static guint egg_data_points_signals[LAST_SIGNAL] = { 0 };
+
+static GQuark egg_data_points_index_quark = 0;
+
+static void on_x_value_changed (GtkAdjustment *adjustment, EggDataPoints *points);
+static void on_y_value_changed (GtkAdjustment *adjustment, EggDataPoints *points);
+static void release_adjustments (EggDataPoints *points, GHashTable *adjustments);
+static gint find_segment (EggDataPointsPrivate *priv, gdouble x);
+
+
+EggDataPoints *
+egg_data_points_new (gdouble lower_x, gdouble upper_x,
+                     gdouble lower_y, gdouble upper_y)
+{
+    GObject *object;
+
+    object = g_object_new (EGG_TYPE_DATA_POINTS,
+                           "lower-x", lower_x,
+                           "upper-x", upper_x,
+                           "lower-y", lower_y,
+                           "upper-y", upper_y,
+                           NULL);
+
+    return EGG_DATA_POINTS (object);
+}
+
+void
+egg_data_points_get_x_range (EggDataPoints *points,
+                             gdouble       *lower_x,
+                             gdouble       *upper_x)
+{
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+    *lower_x = points->priv->lower_x;
+    *upper_x = points->priv->upper_x;
+}
+
+void
+egg_data_points_get_y_range (EggDataPoints *points,
+                             gdouble       *lower_y,
+                             gdouble       *upper_y)
+{
+
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+    *lower_y = points->priv->lower_y;
+    *upper_y = points->priv->upper_y;
+}
+
+static inline gdouble *
+value_location (EggDataPointsPrivate *priv, GArray *values, guint index)
+{
+    if (index >= priv->gap_start)
+        index += priv->gap_size;
+
+    return &g_array_index (values, gdouble, index);
+}
+
+static inline gdouble
+get_x_value (EggDataPointsPrivate *priv, guint index)
+{
+    return *value_location (priv, priv->x_values, index);
+}
+
+static inline gdouble
+get_y_value (EggDataPointsPrivate *priv, guint index)
+{
+    return *value_location (priv, priv->y_values, index);
+}
+
+static void
+move_gap_of (GArray *values, guint from, guint to, guint gap_size)
+{
+    gdouble *data = (gdouble *) values->data;
+
+    if (to < from)
+        memmove (data + to + gap_size, data + to, (from - to) * sizeof (gdouble));
+    else
+        memmove (data + from, data + from + gap_size, (to - from) * sizeof (gdouble));
+}
+
+/* Move the gap so that it starts in front of the point at @index */
+static void
+move_gap (EggDataPointsPrivate *priv, guint index)
+{
+    if (index == priv->gap_start)
+        return;
+
+    if (priv->gap_size > 0) {
+        move_gap_of (priv->x_values, priv->gap_start, index, priv->gap_size);
+        move_gap_of (priv->y_values, priv->gap_start, index, priv->gap_size);
+        move_gap_of (priv->increments, priv->gap_start, index, priv->gap_size);
+    }
+
+    priv->gap_start = index;
+}
+
+static void
+grow_gap_of (GArray *values, guint gap_end, guint n_tail, guint size)
+{
+    g_array_set_size (values, size);
+    memmove (&g_array_index (values, gdouble, size - n_tail),
+             &g_array_index (values, gdouble, gap_end),
+             n_tail * sizeof (gdouble));
+}
+
+/*
+ * Make room for at least @n points in the gap. The storage grows by at least
+ * the number of points, so that growing is amortized over many insertions.
+ */
+static void
+ensure_gap (EggDataPointsPrivate *priv, guint n)
+{
+    guint n_tail = priv->n_points - priv->gap_start;
+    guint gap_end = priv->gap_start + priv->gap_size;
+    guint size;
+
+    if (priv->gap_size >= n)
+        return;
+
+    size = priv->n_points + MAX (n, MAX (priv->n_points, MIN_GAP_SIZE));
+    grow_gap_of (priv->x_values, gap_end, n_tail, size);
+    grow_gap_of (priv->y_values, gap_end, n_tail, size);
+    grow_gap_of (priv->increments, gap_end, n_tail, size);
+    priv->gap_size = size - priv->n_points;
+}
+
+/*
+ * Open @n uninitialized slots at @index. Returns the position of the first
+ * one in the arrays, the others follow contiguously.
+ */
+static guint
+open_slots (EggDataPointsPrivate *priv, guint index, guint n)
+{
+    move_gap (priv, index);
+    ensure_gap (priv, n);
+    priv->gap_start += n;
+    priv->gap_size  -= n;
+    priv->n_points  += n;
+
+    return index;
+}
+
+/* Drop the @n points starting at @index by adding them to the gap */
+static void
+close_slots (EggDataPointsPrivate *priv, guint index, guint n)
+{
+    move_gap (priv, index);
+    priv->gap_size += n;
+    priv->n_points -= n;
+}
+
+/*
+ * Every adjustment handed out carries its current point index as qdata, so a
+ * value change resolves its index without searching. The index is stored off
+ * by one to tell it apart from unset qdata.
+ */
+static inline void
+set_adjustment_index (GtkAdjustment *adj, guint index)
+{
+    g_object_set_qdata (G_OBJECT (adj), egg_data_points_index_quark, GUINT_TO_POINTER (index + 1));
+}
+
+static inline gboolean
+get_adjustment_index (GtkAdjustment *adj, guint *index)
+{
+    guint data;
+
+    data = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (adj), egg_data_points_index_quark));
+    *index = data - 1;
+    return data > 0;
+}
+
+static void
+invalidate_luts (EggDataPointsPrivate *priv)
+{
+    g_free (priv->lut_u8);
+    g_free (priv->lut_u16);
+    g_free (priv->lut_float);
+    priv->lut_u8 = NULL;
+    priv->lut_u16 = NULL;
+    priv->lut_float = NULL;
+    priv->lut_float_size = 0;
+}
+
+static void
+invalidate_tree (EggDataPointsPrivate *priv)
+{
+    if (priv->tree != NULL) {
+        egg_kd_tree_free (priv->tree);
+        priv->tree = NULL;
+    }
+}
+
+static void
+invalidate_extrema (EggDataPointsPrivate *priv)
+{
+    g_free (priv->extrema);
+    priv->extrema = NULL;
+    priv->extrema_levels = 0;
+}
+
+static inline guint
+level_size (EggDataPointsPrivate *priv, guint level)
+{
+    return (guint) (((guint64) priv->n_points + (1ull << level) - 1) >> level);
+}
+
+/* Merge the extrema of @block on @level into @min_index and @max_index */
+static inline void
+merge_extrema (EggDataPointsPrivate *priv, guint level, guint block, guint *min_index, guint *max_index)
+{
+    guint lower = block;
+    guint upper = block;
+
+    if (level > 0) {
+        const guint *pair = priv->extrema + 2 * (priv->extrema_offsets[level] + block);
+        lower = pair[0];
+        upper = pair[1];
+    }
+
+    if (*min_index == G_MAXUINT || get_y_value (priv, lower) < get_y_value (priv, *min_index))
+        *min_index = lower;
+
+    if (*max_index == G_MAXUINT || get_y_value (priv, upper) > get_y_value (priv, *max_index))
+        *max_index = upper;
+}
+
+static void
+compute_extrema (EggDataPointsPrivate *priv, guint level, guint block)
+{
+    guint *pair = priv->extrema + 2 * (priv->extrema_offsets[level] + block);
+
+    pair[0] = pair[1] = G_MAXUINT;
+    merge_extrema (priv, level - 1, 2 * block, &pair[0], &pair[1]);
+
+    if (2 * block + 1 < level_size (priv, level - 1))
+        merge_extrema (priv, level - 1, 2 * block + 1, &pair[0], &pair[1]);
+}
+
+static void
+ensure_extrema (EggDataPointsPrivate *priv)
+{
+    gsize n_pairs = 0;
+    guint levels = 0;
+
+    if (priv->extrema != NULL || priv->n_points < 2)
+        return;
+
+    while (level_size (priv, levels) > 1) {
+        levels++;
+        priv->extrema_offsets[levels] = n_pairs;
+        n_pairs += level_size (priv, levels);
+    }
+
+    priv->extrema = g_new (guint, 2 * n_pairs);
+    priv->extrema_levels = levels;
+
+    for (guint level = 1; level <= levels; level++) {
+        guint n_blocks = level_size (priv, level);
+
+        for (guint block = 0; block < n_blocks; block++)
+            compute_extrema (priv, level, block);
+    }
+}
+
+/* Repair the blocks containing @index after its y value changed */
+static void
+update_extrema (EggDataPointsPrivate *priv, guint index)
+{
+    if (priv->extrema == NULL)
+        return;
+
+    for (guint level = 1; level <= priv->extrema_levels; level++)
+        compute_extrema (priv, level, index >> level);
+}
+
+static EggKdTree *
+ensure_tree (EggDataPointsPrivate *priv)
+{
+    if (priv->tree == NULL) {
+        /* The tree is built from contiguous arrays */
+        move_gap (priv, priv->n_points);
+        priv->tree = egg_kd_tree_new (priv->lower_x, 1.0 / (priv->upper_x - priv->lower_x),
+                                      priv->lower_y, 1.0 / (priv->upper_y - priv->lower_y));
+        egg_kd_tree_build (priv->tree,
+                           (gdouble *) priv->x_values->data,
+                           (gdouble *) priv->y_values->data,
+                           priv->n_points);
+    }
+
+    return priv->tree;
+}
+
+static void
+push_history (EggDataPointsPrivate *priv, guint first, guint last, gboolean structural)
+{
+    ChangeRange *range;
+
+    priv->generation++;
+
+    /* Changes within one update share a single entry */
+    if (priv->update_depth > 0 && priv->dirty) {
+        range = &priv->history[(priv->history_head + HISTORY_SIZE - 1) % HISTORY_SIZE];
+        range->first = MIN (range->first, first);
+        range->last  = MAX (range->last, last);
+        range->structural |= structural;
+        range->generation = priv->generation;
+        return;
+    }
+
+    range = &priv->history[priv->history_head];
+
+    if (range->generation > 0)
+        priv->history_floor = range->generation;
+
+    range->generation = priv->generation;
+    range->first = first;
+    range->last  = last;
+    range->structural = structural;
+    priv->history_head = (priv->history_head + 1) % HISTORY_SIZE;
+}
+
+/*
+ * Advance the generation and merge [first, last] into the pending range if an
+ * update is open. @structural changes insert or remove points, so that the
+ * indices from @first on refer to other points. Returns FALSE if the change
+ * has to be announced right away.
+ */
+static gboolean
+record_change (EggDataPointsPrivate *priv, guint first, guint last, gboolean structural)
+{
+    push_history (priv, first, last, structural);
+
+    if (priv->update_depth == 0)
+        return FALSE;
+
+    if (priv->dirty) {
+        priv->dirty_first = MIN (priv->dirty_first, first);
+        priv->dirty_last  = MAX (priv->dirty_last, last);
+    }
+    else {
+        priv->dirty = TRUE;
+        priv->dirty_first = first;
+        priv->dirty_last  = last;
+    }
+
+    return TRUE;
+}
+
+static void
+emit_points_changed (EggDataPoints *points, guint first, guint last, gboolean structural)
+{
+    if (!record_change (points->priv, first, last, structural))
+        g_signal_emit (points, egg_data_points_signals[POINTS_CHANGED], 0, first, last);
+}
+
+/*
+ * Store a new coordinate value, keep derived indices in sync and notify. The
+ * value must already be clamped to the data range.
+ */
+static void
+write_value (EggDataPoints *points, GArray *values, guint index, gdouble value)
+{
+    EggDataPointsPrivate *priv = points->priv;
+    gdouble *location = value_location (priv, values, index);
+    gdouble old_x, old_y;
+
+    if (*location == value)
+        return;
+
+    old_x = get_x_value (priv, index);
+    old_y = get_y_value (priv, index);
+    *location = value;
+
+    if (priv->tree != NULL)
+        egg_kd_tree_move (priv->tree, index, old_x, old_y,
+                          get_x_value (priv, index), get_y_value (priv, index));
+
+    if (values == priv->y_values)
+        update_extrema (priv, index);
+
+    invalidate_luts (priv);
+
+    if (!record_change (priv, index, index, FALSE))
+        g_signal_emit (points, egg_data_points_signals[VALUE_CHANGED], 0, index);
+}
+
+static GtkAdjustment *
+create_adjustment (EggDataPoints *points,
+                   GHashTable    *adjustments,
+                   GCallback      callback,
+                   guint          index,
+                   gdouble        value,
+                   gdouble        lower,
+                   gdouble        upper)
+{
+    GtkAdjustment *adj;
+    gdouble increment;
+
+    increment = *value_location (points->priv, points->priv->increments, index);
+    adj = GTK_ADJUSTMENT (gtk_adjustment_new (value, lower, upper, increment, 10, 0));
+    g_object_ref_sink (adj);
+    set_adjustment_index (adj, index);
+    g_signal_connect (adj, "value-changed", callback, points);
+    g_hash_table_insert (adjustments, GUINT_TO_POINTER (index), adj);
+
+    return adj;
+}
+
+static void
+release_adjustment (EggDataPoints *points, GtkAdjustment *adj)
+{
+    g_signal_handlers_disconnect_by_func (adj, on_x_value_changed, points);
+    g_signal_handlers_disconnect_by_func (adj, on_y_value_changed, points);
+    g_object_set_qdata (G_OBJECT (adj), egg_data_points_index_quark, NULL);
+    g_object_unref (adj);
+}
+
+/*
+ * Move all adjustments with an index of at least @first by @offset positions.
+ * Only the adjustments that were actually handed out are touched.
+ */
+static void
+shift_adjustments (GHashTable *adjustments, guint first, gint offset)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+    GSList *moved = NULL;
+
+    g_hash_table_iter_init (&iter, adjustments);
+
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        if (GPOINTER_TO_UINT (key) >= first) {
+            moved = g_slist_prepend (moved, key);
+            moved = g_slist_prepend (moved, value);
+        }
+    }
+
+    for (GSList *it = moved; it != NULL; it = it->next->next)
+        g_hash_table_steal (adjustments, it->next->data);
+
+    for (GSList *it = moved; it != NULL; it = it->next->next) {
+        guint index = GPOINTER_TO_UINT (it->next->data) + offset;
+
+        set_adjustment_index (GTK_ADJUSTMENT (it->data), index);
+        g_hash_table_insert (adjustments, GUINT_TO_POINTER (index), it->data);
+    }
+
+    g_slist_free (moved);
+}
+
+guint
+egg_data_points_add_point (EggDataPoints *points,
+                           gdouble        x,
+                           gdouble        y,
+                           gdouble        increment)
+{
+    EggDataPointsPrivate *priv;
+    guint index;
+    guint slot;
+
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (points), 0);
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (points);
+    x = CLAMP (x, priv->lower_x, priv->upper_x);
+    y = CLAMP (y, priv->lower_y, priv->upper_y);
+
+    index = priv->n_points;
+    slot = open_slots (priv, index, 1);
+    g_array_index (priv->x_values, gdouble, slot) = x;
+    g_array_index (priv->y_values, gdouble, slot) = y;
+    g_array_index (priv->increments, gdouble, slot) = increment;
+
+    if (priv->tree != NULL)
+        egg_kd_tree_insert (priv->tree, index, x, y);
+
+    invalidate_extrema (priv);
+    invalidate_luts (priv);
+    record_change (priv, index, index, TRUE);
+
+    return index;
+}
+
+static void
+copy_clamped (GArray        *values,
+              guint          offset,
+              const gdouble *src,
+              guint          n,
+              gdouble        lower,
+              gdouble        upper)
+{
+    gdouble *dst = &g_array_index (values, gdouble, offset);
+
+    for (guint i = 0; i < n; i++)
+        dst[i] = CLAMP (src[i], lower, upper);
+}
+
+static GArray *
+replace_values (GArray *values, guint n)
+{
+    g_array_free (values, TRUE);
+    values = g_array_sized_new (FALSE, FALSE, sizeof (gdouble), n);
+    g_array_set_size (values, n);
+
+    return values;
+}
+
+/* Fill the @n slots starting at @slot */
+static void
+write_points (EggDataPointsPrivate *priv,
+              guint                 slot,
+              const gdouble        *xs,
+              const gdouble        *ys,
+              guint                 n)
+{
+    copy_clamped (priv->x_values, slot, xs, n, priv->lower_x, priv->upper_x);
+    copy_clamped (priv->y_values, slot, ys, n, priv->lower_y, priv->upper_y);
+
+    for (guint i = slot; i < slot + n; i++)
+        g_array_index (priv->increments, gdouble, i) = 1.0;
+}
+
+/* Insert @n points at @index, moving the following points only once */
+static void
+insert_points (EggDataPointsPrivate *priv,
+               guint                 index,
+               const gdouble        *xs,
+               const gdouble        *ys,
+               guint                 n)
+{
+    write_points (priv, open_slots (priv, index, n), xs, ys, n);
+}
+
+/**
+ * egg_data_points_set_points_from_arrays:
+ *
+ * Replace all points with the @n coordinates in @xs and @ys. Adjustments that
+ * were handed out for the previous points are detached from the store. A
+ * single "points-changed::" signal is emitted for the whole range.
+ */
+void
+egg_data_points_set_points_from_arrays (EggDataPoints *points,
+                                        const gdouble *xs,
+                                        const gdouble *ys,
+                                        guint          n)
+{
+    EggDataPointsPrivate *priv;
+    guint old_n;
+
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+    g_return_if_fail (n == 0 || (xs != NULL && ys != NULL));
+
+    priv  = EGG_DATA_POINTS_GET_PRIVATE (points);
+    old_n = priv->n_points;
+
+    release_adjustments (points, priv->x_adjustments);
+    release_adjustments (points, priv->y_adjustments);
+
+    /* Storage is sized for exactly @n points, a gap only opens with later
+     * edits. New arrays also release the memory of a larger previous load. */
+    priv->x_values   = replace_values (priv->x_values, n);
+    priv->y_values   = replace_values (priv->y_values, n);
+    priv->increments = replace_values (priv->increments, n);
+    priv->n_points  = n;
+    priv->gap_start = n;
+    priv->gap_size  = 0;
+    write_points (priv, 0, xs, ys, n);
+    invalidate_tree (priv);
+    invalidate_extrema (priv);
+    invalidate_luts (priv);
+
+    if (old_n > 0 || n > 0)
+        emit_points_changed (points, 0, MAX (old_n, n) - 1, TRUE);
+}
+
+/**
+ * egg_data_points_append_points:
+ *
+ * Append the @n coordinates in @xs and @ys and emit a single
+ * "points-changed::" signal for the new range.
+ */
+void
+egg_data_points_append_points (EggDataPoints *points,
+                               const gdouble *xs,
+                               const gdouble *ys,
+                               guint          n)
+{
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+
+    egg_data_points_insert_points (points, points->priv->n_points, xs, ys, n);
+}
+
+/**
+ * egg_data_points_insert_points:
+ *
+ * Insert the @n coordinates in @xs and @ys in front of the point at @index,
+ * or append them if @index equals the number of points. Subsequent points
+ * are moved once for the whole batch and a single "points-changed::" signal
+ * is emitted for all points from @index on.
+ */
+void
+egg_data_points_insert_points (EggDataPoints *points,
+                               guint          index,
+                               const gdouble *xs,
+                               const gdouble *ys,
+                               guint          n)
+{
+    EggDataPointsPrivate *priv;
+
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+    g_return_if_fail (n == 0 || (xs != NULL && ys != NULL));
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (points);
+    g_return_if_fail (index <= priv->n_points);
+
+    if (n == 0)
+        return;
+
+    insert_points (priv, index, xs, ys, n);
+    shift_adjustments (priv->x_adjustments, index, n);
+    shift_adjustments (priv->y_adjustments, index, n);
+    invalidate_tree (priv);
+    invalidate_extrema (priv);
+    invalidate_luts (priv);
+
+    emit_points_changed (points, index, priv->n_points - 1, TRUE);
+}
+
+/* Detach the adjustments of the points in [first, first + n) */
+static void
+release_adjustment_range (EggDataPoints *points, GHashTable *adjustments, guint first, guint n)
+{
+    for (guint i = first; i < first + n; i++) {
+        GtkAdjustment *adj = g_hash_table_lookup (adjustments, GUINT_TO_POINTER (i));
+
+        if (adj != NULL) {
+            g_hash_table_remove (adjustments, GUINT_TO_POINTER (i));
+            release_adjustment (points, adj);
+        }
+    }
+}
+
+/**
+ * egg_data_points_remove_points:
+ *
+ * Remove the @n points starting at @index. Subsequent points are moved once
+ * for the whole batch and a single "points-changed::" signal is emitted for
+ * all points from @index to the previous end.
+ */
+void
+egg_data_points_remove_points (EggDataPoints *points,
+                               guint          index,
+                               guint          n)
+{
+    EggDataPointsPrivate *priv;
+    guint old_n;
+
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (points);
+    g_return_if_fail (index <= priv->n_points && n <= priv->n_points - index);
+
+    if (n == 0)
+        return;
+
+    old_n = priv->n_points;
+    release_adjustment_range (points, priv->x_adjustments, index, n);
+    release_adjustment_range (points, priv->y_adjustments, index, n);
+    close_slots (priv, index, n);
+    shift_adjustments (priv->x_adjustments, index + n, -(gint) n);
+    shift_adjustments (priv->y_adjustments, index + n, -(gint) n);
+    invalidate_tree (priv);
+    invalidate_extrema (priv);
+    invalidate_luts (priv);
+
+    emit_points_changed (points, index, old_n - 1, TRUE);
+}
+
+/**
+ * egg_data_points_insert_point:
+ *
+ * Insert a new point at the given index and move subsequent indices, or
+ * append it if @index equals the number of points. After insertion the
+ * "point-inserted::" signal is emitted. Insertions close to the previous
+ * insertion or removal only move the points in between.
+ */
+void
+egg_data_points_insert_point (EggDataPoints *points,
+                              guint          index,
+                              gdouble        x,
+                              gdouble        y)
+{
+    EggDataPointsPrivate *priv;
+    guint slot;
+
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (points);
+    g_return_if_fail (index <= priv->n_points);
+
+    x = CLAMP (x, priv->lower_x, priv->upper_x);
+    y = CLAMP (y, priv->lower_y, priv->upper_y);
+
+    slot = open_slots (priv, index, 1);
+    g_array_index (priv->x_values, gdouble, slot) = x;
+    g_array_index (priv->y_values, gdouble, slot) = y;
+    g_array_index (priv->increments, gdouble, slot) = 1.0;
+    shift_adjustments (priv->x_adjustments, index, 1);
+    shift_adjustments (priv->y_adjustments, index, 1);
+
+    if (priv->tree != NULL)
+        egg_kd_tree_insert (priv->tree, index, x, y);
+
+    invalidate_extrema (priv);
+    invalidate_luts (priv);
+
+    if (!record_change (priv, index, priv->n_points - 1, TRUE))
+        g_signal_emit (points, egg_data_points_signals[POINT_INSERTED], 0, index);
+}
+
+/**
+ * egg_data_points_insert_sorted:
+ *
+ * Insert a new point behind all points with an x coordinate of at most @x.
+ * The index is found by binary search, so the points must be sorted by x as
+ * enforced by the view's "restrict-x" property. See
+ * egg_data_points_insert_point().
+ *
+ * Returns: the index of the new point.
+ */
+guint
+egg_data_points_insert_sorted (EggDataPoints *points,
+                               gdouble        x,
+                               gdouble        y)
+{
+    EggDataPointsPrivate *priv;
+    guint index;
+
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (points), 0);
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (points);
+    x = CLAMP (x, priv->lower_x, priv->upper_x);
+    index = (guint) (find_segment (priv, x) + 1);
+    egg_data_points_insert_point (points, index, x, y);
+
+    return index;
+}
+
+void
+egg_data_points_remove_point (EggDataPoints *points,
+                              guint          index)
+{
+    EggDataPointsPrivate *priv;
+
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (points);
+    g_return_if_fail (index < priv->n_points);
+
+    release_adjustment_range (points, priv->x_adjustments, index, 1);
+    release_adjustment_range (points, priv->y_adjustments, index, 1);
+
+    if (priv->tree != NULL)
+        egg_kd_tree_remove (priv->tree, index, get_x_value (priv, index), get_y_value (priv, index));
+
+    close_slots (priv, index, 1);
+    shift_adjustments (priv->x_adjustments, index + 1, -1);
+    shift_adjustments (priv->y_adjustments, index + 1, -1);
+
+    invalidate_extrema (priv);
+    invalidate_luts (priv);
+
+    if (!record_change (priv, index, priv->n_points, TRUE))
+        g_signal_emit (points, egg_data_points_signals[POINT_REMOVED], 0, index);
+}
+
+/**
+ * egg_data_points_begin_update:
+ *
+ * Open an update. Until the matching egg_data_points_end_update() no
+ * "value-changed::", "point-inserted::" or "point-removed::" signals are
+ * emitted. Updates can be nested.
+ */
+void
+egg_data_points_begin_update (EggDataPoints *points)
+{
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+    points->priv->update_depth++;
+}
+
+/**
+ * egg_data_points_end_update:
+ *
+ * Close an update. When the outermost update is closed, a single
+ * "points-changed::" signal is emitted covering all points that were touched.
+ */
+void
+egg_data_points_end_update (EggDataPoints *points)
+{
+    EggDataPointsPrivate *priv;
+
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (points);
+    g_return_if_fail (priv->update_depth > 0);
+
+    if (--priv->update_depth > 0 || !priv->dirty)
+        return;
+
+    priv->dirty = FALSE;
+    g_signal_emit (points, egg_data_points_signals[POINTS_CHANGED], 0,
+                   priv->dirty_first, priv->dirty_last);
+}
+
+/**
+ * egg_data_points_get_generation:
+ *
+ * Returns: a number that grows with every change of the points.
+ */
+guint64
+egg_data_points_get_generation (EggDataPoints *points)
+{
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (points), 0);
+    return points->priv->generation;
+}
+
+/**
+ * egg_data_points_get_changes_since:
+ * @generation: a value previously returned by egg_data_points_get_generation()
+ * @first: location for the first changed index
+ * @last: location for the last changed index
+ * @structural: (allow-none): location for whether points were inserted or
+ *     removed, or %NULL
+ *
+ * Find the range of points that changed after @generation. If the change
+ * is too old to be remembered, @first is 0 and @last is %G_MAXUINT. Like for
+ * "points-changed::", indices beyond egg_data_points_get_num() refer to
+ * points that were removed. If @structural is set, indices from @first on
+ * may refer to other points than at @generation, even if the number of
+ * points stayed the same.
+ *
+ * Returns: %TRUE if anything changed since @generation.
+ */
+gboolean
+egg_data_points_get_changes_since (EggDataPoints *points,
+                                   guint64        generation,
+                                   guint         *first,
+                                   guint         *last,
+                                   gboolean      *structural)
+{
+    gboolean any_structural = FALSE;
+
+    EggDataPointsPrivate *priv;
+
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (points), FALSE);
+    g_return_val_if_fail (first != NULL && last != NULL, FALSE);
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (points);
+
+    if (generation >= priv->generation)
+        return FALSE;
+
+    if (generation < priv->history_floor) {
+        *first = 0;
+        *last  = G_MAXUINT;
+
+        if (structural != NULL)
+            *structural = TRUE;
+
+        return TRUE;
+    }
+
+    *first = G_MAXUINT;
+    *last  = 0;
+
+    for (guint i = 0; i < HISTORY_SIZE; i++) {
+        ChangeRange *range = &priv->history[i];
+
+        if (range->generation > generation) {
+            *first = MIN (*first, range->first);
+            *last  = MAX (*last, range->last);
+            any_structural |= range->structural;
+        }
+    }
+
+    if (structural != NULL)
+        *structural = any_structural;
+
+    return TRUE;
+}
+
+guint
+egg_data_points_get_num (EggDataPoints *points)
+{
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (points), 0);
+    return points->priv->n_points;
+}
+
+/**
+ * egg_data_points_get_x:
+ *
+ * Return the adjustment that controls the x coordinate of the point at
+ * @index. The adjustment is created on first use and stays in sync with the
+ * store until the point is removed.
+ */
+GtkAdjustment *
+egg_data_points_get_x (EggDataPoints *data_points,
+                       guint          index)
+{
+    EggDataPointsPrivate *priv;
+    GtkAdjustment        *adj;
+
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (data_points), NULL);
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (data_points);
+    g_return_val_if_fail (index < priv->n_points, NULL);
+
+    adj = g_hash_table_lookup (priv->x_adjustments, GUINT_TO_POINTER (index));
+
+    if (adj == NULL)
+        adj = create_adjustment (data_points, priv->x_adjustments,
+                                 G_CALLBACK (on_x_value_changed), index,
+                                 get_x_value (priv, index), priv->lower_x, priv->upper_x);
+
+    return adj;
+}
+
+/**
+ * egg_data_points_get_y:
+ *
+ * Return the adjustment that controls the y coordinate of the point at
+ * @index. See egg_data_points_get_x().
+ */
+GtkAdjustment *
+egg_data_points_get_y (EggDataPoints *data_points,
+                       guint          index)
+{
+    EggDataPointsPrivate *priv;
+    GtkAdjustment        *adj;
+
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (data_points), NULL);
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (data_points);
+    g_return_val_if_fail (index < priv->n_points, NULL);
+
+    adj = g_hash_table_lookup (priv->y_adjustments, GUINT_TO_POINTER (index));
+
+    if (adj == NULL)
+        adj = create_adjustment (data_points, priv->y_adjustments,
+                                 G_CALLBACK (on_y_value_changed), index,
+                                 get_y_value (priv, index), priv->lower_y, priv->upper_y);
+
+    return adj;
+}
+
+gdouble egg_data_points_get_x_value (EggDataPoints *data_points,
+                                     guint          index)
+{
+    EggDataPointsPrivate *priv;
+
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (data_points), 0.0);
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (data_points);
+    g_return_val_if_fail (index < priv->n_points, 0.0);
+
+    return get_x_value (priv, index);
+}
+
+gdouble egg_data_points_get_y_value (EggDataPoints *data_points,
+                                     guint          index)
+{
+    EggDataPointsPrivate *priv;
+
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (data_points), 0.0);
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (data_points);
+    g_return_val_if_fail (index < priv->n_points, 0.0);
+
+    return get_y_value (priv, index);
+}
+
+/**
+ * egg_data_points_get_y_extrema:
+ * @min_index: location for the index of the smallest y value
+ * @max_index: location for the index of the largest y value
+ *
+ * Find the points with the smallest and largest y value among the points in
+ * [@first, @last] in O(log n), using a min/max pyramid that is built on the
+ * first call and kept up to date while values change.
+ */
+void
+egg_data_points_get_y_extrema (EggDataPoints *points,
+                               guint          first,
+                               guint          last,
+                               guint         *min_index,
+                               guint         *max_index)
+{
+    EggDataPointsPrivate *priv;
+    guint lower, upper;
+
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+    g_return_if_fail (min_index != NULL && max_index != NULL);
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (points);
+    g_return_if_fail (first <= last && last < priv->n_points);
+
+    ensure_extrema (priv);
+    *min_index = *max_index = G_MAXUINT;
+
+    /* Walk up the pyramid, taking partial blocks at both ends */
+    lower = first;
+    upper = last + 1;
+
+    for (guint level = 0; lower < upper; level++) {
+        if (lower & 1)
+            merge_extrema (priv, level, lower++, min_index, max_index);
+
+        if (upper & 1)
+            merge_extrema (priv, level, --upper, min_index, max_index);
+
+        lower >>= 1;
+        upper >>= 1;
+    }
+}
+
+/* Copy @n values starting at @first, in two parts if they span the gap */
+static void
+copy_values (EggDataPointsPrivate *priv, GArray *values, guint first, guint n, gdouble *dst)
+{
+    guint before = first < priv->gap_start ? MIN (n, priv->gap_start - first) : 0;
+
+    if (before > 0)
+        memcpy (dst, value_location (priv, values, first), before * sizeof (gdouble));
+
+    if (n > before)
+        memcpy (dst + before, value_location (priv, values, first + before), (n - before) * sizeof (gdouble));
+}
+
+/**
+ * egg_data_points_get_values:
+ * @xs: location for @n x values or %NULL
+ * @ys: location for @n y values or %NULL
+ *
+ * Copy the coordinates of the @n points starting at @first.
+ */
+void
+egg_data_points_get_values (EggDataPoints *points,
+                            guint          first,
+                            guint          n,
+                            gdouble       *xs,
+                            gdouble       *ys)
+{
+    EggDataPointsPrivate *priv;
+
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (points);
+    g_return_if_fail (first + n <= priv->n_points);
+
+    if (xs != NULL)
+        copy_values (priv, priv->x_values, first, n, xs);
+
+    if (ys != NULL)
+        copy_values (priv, priv->y_values, first, n, ys);
+}
+
+static void
+set_value (EggDataPoints *points,
+           GArray        *values,
+           GHashTable    *adjustments,
+           guint          index,
+           gdouble        value,
+           gdouble        lower,
+           gdouble        upper)
+{
+    GtkAdjustment *adj;
+
+    adj = g_hash_table_lookup (adjustments, GUINT_TO_POINTER (index));
+
+    /* The adjustment writes back through its value-changed handler */
+    if (adj != NULL) {
+        gtk_adjustment_set_value (adj, value);
+        return;
+    }
+
+    write_value (points, values, index, CLAMP (value, lower, upper));
+}
+
+void
+egg_data_points_set_x (EggDataPoints *data_points,
+                       guint          index,
+                       gdouble        value)
+{
+    EggDataPointsPrivate *priv;
+
+    g_return_if_fail (EGG_IS_DATA_POINTS (data_points));
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (data_points);
+    g_return_if_fail (index < priv->n_points);
+
+    set_value (data_points, priv->x_values, priv->x_adjustments, index, value,
+               priv->lower_x, priv->upper_x);
+}
+
+void
+egg_data_points_set_y (EggDataPoints *data_points,
+                       guint          index,
+                       gdouble        value)
+{
+    EggDataPointsPrivate *priv;
+
+    g_return_if_fail (EGG_IS_DATA_POINTS (data_points));
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (data_points);
+    g_return_if_fail (index < priv->n_points);
+
+    set_value (data_points, priv->y_values, priv->y_adjustments, index, value,
+               priv->lower_y, priv->upper_y);
+}
+
+/**
+ * egg_data_get_closest_point:
+ *
+ * Find the point closest to (@x, @y). Distances are measured in coordinates
+ * normalized to the data range.
+ */
+guint
+egg_data_get_closest_point (EggDataPoints *points,
+                            gdouble        x,
+                            gdouble        y,
+                            gdouble       *distance)
+{
+    guint index = 0;
+
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (points), 0);
+
+    if (egg_data_points_get_closest_points (points, x, y, 1, &index, distance) == 0)
+        *distance = DBL_MAX;
+
+    return index;
+}
+
+/**
+ * egg_data_points_get_closest_points:
+ *
+ * Find up to @k points closest to (@x, @y) and store their indices and
+ * normalized distances in @indices and @distances, closest first.
+ *
+ * Returns: the number of points found.
+ */
+guint
+egg_data_points_get_closest_points (EggDataPoints *points,
+                                    gdouble        x,
+                                    gdouble        y,
+                                    guint          k,
+                                    guint         *indices,
+                                    gdouble       *distances)
+{
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (points), 0);
+    return egg_kd_tree_nearest (ensure_tree (points->priv), x, y, k, indices, distances);
+}
+
+/**
+ * egg_data_points_find_points_in_radius:
+ *
+ * Append the indices of all points with a normalized distance of at most
+ * @radius from (@x, @y) to @indices in no particular order. Reusing
+ * @indices keeps repeated queries free of allocations.
+ */
+void
+egg_data_points_find_points_in_radius (EggDataPoints *points,
+                                       gdouble        x,
+                                       gdouble        y,
+                                       gdouble        radius,
+                                       GArray        *indices)
+{
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+    g_return_if_fail (indices != NULL);
+    egg_kd_tree_within (ensure_tree (points->priv), x, y, radius, indices);
+}
+
+/**
+ * egg_data_points_get_points_in_radius:
+ *
+ * Find all points with a normalized distance of at most @radius from
+ * (@x, @y).
+ *
+ * Returns: a #GArray of guint indices in no particular order. Free it with
+ * g_array_free().
+ */
+GArray *
+egg_data_points_get_points_in_radius (EggDataPoints *points,
+                                      gdouble        x,
+                                      gdouble        y,
+                                      gdouble        radius)
+{
+    GArray *indices;
+
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (points), NULL);
+
+    indices = g_array_new (FALSE, FALSE, sizeof (guint));
+    egg_data_points_find_points_in_radius (points, x, y, radius, indices);
+    return indices;
+}
+
+/*
+ * Return the largest i with x_i <= x, or -1 if x lies left of all points.
+ * Requires the points to be sorted by x.
+ */
+static gint
+find_segment (EggDataPointsPrivate *priv, gdouble x)
+{
+    gint lo = 0;
+    gint hi = priv->n_points;
+
+    while (lo < hi) {
+        gint mid = lo + (hi - lo) / 2;
+
+        if (get_x_value (priv, mid) <= x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo - 1;
+}
+
+static inline gdouble
+interpolate (EggDataPointsPrivate *priv, gint segment, gdouble x)
 {
-    POINT_INSERTED,
-    POINT_REMOVED,
-    VALUE_CHANGED,
-    LAST_SIGNAL
-};
+    gdouble x0 = get_x_value (priv, segment);
+    gdouble y0 = get_y_value (priv, segment);
+    gdouble x1 = get_x_value (priv, segment + 1);
+    gdouble y1 = get_y_value (priv, segment + 1);
 
-static GParamSpec *egg_data_points_properties[N_PROPERTIES] = { NULL, };
+    return y0 + (x - x0) * (y1 - y0) / (x1 - x0);
+}
 
-static guint egg_data_points_signals[LAST_SIGNAL] = { 0 };
+/**
+ * egg_data_points_evaluate:
+ *
+ * Evaluate the piecewise linear function through all points at @x. Points
+ * must be sorted by their x coordinate, as enforced by the view's
+ * "restrict-x" property. Outside the first and last point the function
+ * continues with the y value of that point.
+ *
+ * Returns: the function value at @x, or 0.0 if there are no points.
+ */
+gdouble
+egg_data_points_evaluate (EggDataPoints *points,
+                          gdouble        x)
+{
+    EggDataPointsPrivate *priv;
+    gint segment;
+    guint n;
 
-static void on_value_changed (GtkAdjustment *adjustment, EggDataPoints *points);
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (points), 0.0);
 
+    priv = points->priv;
+    n = priv->n_points;
 
-EggDataPoints *
-egg_data_points_new (gdouble lower_x, gdouble upper_x,
-                     gdouble lower_y, gdouble upper_y)
-{
-    GObject *object;
+    if (n == 0)
+        return 0.0;
 
-    object = g_object_new (EGG_TYPE_DATA_POINTS,
-                           "lower-x", lower_x,
-                           "upper-x", upper_x,
-                           "lower-y", lower_y,
-                           "upper-y", upper_y,
-                           NULL);
+    segment = find_segment (priv, x);
 
-    return EGG_DATA_POINTS (object);
+    if (segment < 0)
+        return get_y_value (priv, 0);
+
+    if (segment == (gint) n - 1)
+        return get_y_value (priv, n - 1);
+
+    return interpolate (priv, segment, x);
 }
 
+/**
+ * egg_data_points_evaluate_many:
+ *
+ * Evaluate the function at the @n positions in @in and store the results in
+ * @out, which may be the same array. Consecutive inputs that fall onto the
+ * same segment are evaluated in one vectorized pass, so sorted input is
+ * processed as a single merge walk over the segments. Unsorted input works
+ * as well but falls back to a search for each input that leaves the current
+ * segment.
+ */
 void
-egg_data_points_get_x_range (EggDataPoints *points,
-                             gdouble       *lower_x,
-                             gdouble       *upper_x)
+egg_data_points_evaluate_many (EggDataPoints *points,
+                               const gdouble *in,
+                               gdouble       *out,
+                               gsize          n)
 {
+    EggDataPointsPrivate *priv;
+    gint  last;
+    gint  segment;
+    gsize i = 0;
+
     g_return_if_fail (EGG_IS_DATA_POINTS (points));
-    *lower_x = points->priv->lower_x;
-    *upper_x = points->priv->upper_x;
+
+    priv = points->priv;
+    last = (gint) priv->n_points - 1;
+
+    if (last < 0 || n == 0) {
+        egg_curve_kernel_fill (out, n, 0.0);
+        return;
+    }
+
+    segment = find_segment (priv, in[0]);
+
+    while (i < n) {
+        gdouble left, right;
+        gsize   end;
+
+        left  = segment < 0 ? -G_MAXDOUBLE : get_x_value (priv, segment);
+        right = segment == last ? G_MAXDOUBLE : get_x_value (priv, segment + 1);
+
+        if (!(in[i] >= left && in[i] < right)) {
+            /* Sorted input continues on one of the next segments, otherwise
+             * search from scratch */
+            if (in[i] >= right && segment + 1 < last && in[i] < get_x_value (priv, segment + 2))
+                segment++;
+            else
+                segment = find_segment (priv, in[i]);
+
+            left  = segment < 0 ? -G_MAXDOUBLE : get_x_value (priv, segment);
+            right = segment == last ? G_MAXDOUBLE : get_x_value (priv, segment + 1);
+        }
+
+        if (segment < 0 || segment == last) {
+            gdouble y = get_y_value (priv, segment < 0 ? 0 : last);
+
+            for (end = i + 1; end < n && in[end] >= left && in[end] < right; end++)
+                ;
+
+            egg_curve_kernel_fill (out + i, end - i, y);
+        }
+        else {
+            gdouble y0 = get_y_value (priv, segment);
+            gdouble y1 = get_y_value (priv, segment + 1);
+
+            end = i + egg_curve_kernel_linear_run (in + i, out + i, n - i, left, right,
+                                                   y0, (y1 - y0) / (right - left));
+        }
+
+        i = end;
+    }
 }
 
-void
-egg_data_points_get_y_range (EggDataPoints *points,
-                             gdouble       *lower_y,
-                             gdouble       *upper_y)
+/*
+ * Evaluate the function at n positions spread evenly over the x range and
+ * return the results normalized to the y range.
+ */
+static gdouble *
+sample_normalized (EggDataPoints *points, guint n)
 {
+    EggDataPointsPrivate *priv = points->priv;
+    gdouble *samples;
+    gdouble  step;
 
-    g_return_if_fail (EGG_IS_DATA_POINTS (points));
-    *lower_y = points->priv->lower_y;
-    *upper_y = points->priv->upper_y;
+    samples = g_new (gdouble, n);
+    step = n > 1 ? (priv->upper_x - priv->lower_x) / (n - 1) : 0.0;
+
+    for (guint i = 0; i < n; i++)
+        samples[i] = priv->lower_x + i * step;
+
+    egg_data_points_evaluate_many (points, samples, samples, n);
+    egg_curve_kernel_linear (samples, samples, n, priv->lower_y, 0.0,
+                             1.0 / (priv->upper_y - priv->lower_y));
+
+    return samples;
 }
 
-guint
-egg_data_points_add_point (EggDataPoints *points,
-                           gdouble        x,
-                           gdouble        y,
-                           gdouble        increment)
+/**
+ * egg_data_points_bake_lut_u8:
+ *
+ * Tabulate the function for 8-bit data: entry i holds the function value at
+ * the i-th of 256 positions spread over the x range, scaled from the y range
+ * to 0..255. The table is cached until a point changes.
+ *
+ * Returns: a table of 256 entries owned by @points. It stays valid until the
+ * next change of the store.
+ */
+const guint8 *
+egg_data_points_bake_lut_u8 (EggDataPoints *points)
 {
     EggDataPointsPrivate *priv;
-    GtkAdjustment *x_adj;
-    GtkAdjustment *y_adj;
 
-    g_return_val_if_fail (EGG_IS_DATA_POINTS (points), 0);
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (points), NULL);
 
-    priv  = EGG_DATA_POINTS_GET_PRIVATE (points);
-    x_adj = GTK_ADJUSTMENT (gtk_adjustment_new (x, priv->lower_x, priv->upper_x, increment, 10, 0));
-    y_adj = GTK_ADJUSTMENT (gtk_adjustment_new (y, priv->lower_y, priv->upper_y, increment, 10, 0));
+    priv = points->priv;
+
+    if (priv->lut_u8 == NULL) {
+        gdouble *samples = sample_normalized (points, 256);
+
+        priv->lut_u8 = g_new (guint8, 256);
 
-    g_object_ref_sink (x_adj);
-    g_object_ref_sink (y_adj);
-    g_ptr_array_add (priv->x_adjustments, x_adj);
-    g_ptr_array_add (priv->y_adjustments, y_adj);
+        for (guint i = 0; i < 256; i++)
+            priv->lut_u8[i] = (guint8) (CLAMP (samples[i], 0.0, 1.0) * G_MAXUINT8 + 0.5);
 
-    g_signal_connect (x_adj, "value-changed", G_CALLBACK (on_value_changed), points);
-    g_signal_connect (y_adj, "value-changed", G_CALLBACK (on_value_changed), points);
+        g_free (samples);
+    }
 
-    return priv->x_adjustments->len - 1;
+    return priv->lut_u8;
 }
 
 /**
- * egg_data_points_insert_point:
+ * egg_data_points_bake_lut_u16:
  *
- * Insert a new point at the given index and move subsequent indices. After
- * insertion the "point-inserted::" signal is emitted.
+ * Tabulate the function for 16-bit data with 65536 entries scaled to
+ * 0..65535. See egg_data_points_bake_lut_u8().
+ *
+ * Returns: a table of 65536 entries owned by @points.
  */
-void
-egg_data_points_insert_point (EggDataPoints *points,
-                              guint          index,
-                              gdouble        x,
-                              gdouble        y)
+const guint16 *
+egg_data_points_bake_lut_u16 (EggDataPoints *points)
 {
     EggDataPointsPrivate *priv;
-    gpointer from_x;
-    gpointer from_y;
-    guint    from_index;
-    guint    n_points;
 
-    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (points), NULL);
 
-    priv = EGG_DATA_POINTS_GET_PRIVATE (points);
-    g_return_if_fail (index < priv->x_adjustments->len);
+    priv = points->priv;
 
-    /* Append the new point */
-    from_index = egg_data_points_add_point (points, x, y, 1.0);
-    n_points   = priv->x_adjustments->len;
-    from_x = egg_data_points_get_x (points, from_index);
-    from_y = egg_data_points_get_y (points, from_index);
+    if (priv->lut_u16 == NULL) {
+        gdouble *samples = sample_normalized (points, 65536);
 
-    for (guint i = index; i < n_points; i++) {
-        gpointer tmp_x = priv->x_adjustments->pdata[i];
-        gpointer tmp_y = priv->y_adjustments->pdata[i];
+        priv->lut_u16 = g_new (guint16, 65536);
 
-        priv->x_adjustments->pdata[i] = from_x;
-        priv->y_adjustments->pdata[i] = from_y;
-        from_x = tmp_x;
-        from_y = tmp_y;
+        for (guint i = 0; i < 65536; i++)
+            priv->lut_u16[i] = (guint16) (CLAMP (samples[i], 0.0, 1.0) * G_MAXUINT16 + 0.5);
+
+        g_free (samples);
     }
 
-    g_signal_emit (points, egg_data_points_signals[POINT_INSERTED], 0, index);
+    return priv->lut_u16;
 }
 
-void
-egg_data_points_remove_point (EggDataPoints *points,
-                              guint          index)
+/**
+ * egg_data_points_bake_lut_float:
+ *
+ * Tabulate the function at @n positions spread over the x range with values
+ * normalized to the y range, i.e. lower_y maps to 0.0 and upper_y to 1.0.
+ * Only the most recently requested size is cached.
+ *
+ * Returns: a table of @n entries owned by @points.
+ */
+const gfloat *
+egg_data_points_bake_lut_float (EggDataPoints *points,
+                                guint          n)
 {
     EggDataPointsPrivate *priv;
-    GObject *object;
 
-    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+    g_return_val_if_fail (EGG_IS_DATA_POINTS (points), NULL);
+    g_return_val_if_fail (n > 0, NULL);
 
-    priv = EGG_DATA_POINTS_GET_PRIVATE (points);
-    object = G_OBJECT (g_ptr_array_remove_index (priv->x_adjustments, index));
-    g_object_unref (object);
-    object = G_OBJECT (g_ptr_array_remove_index (priv->y_adjustments, index));
-    g_object_unref (object);
+    priv = points->priv;
+
+    if (priv->lut_float == NULL || priv->lut_float_size != n) {
+        gdouble *samples = sample_normalized (points, n);
+
+        g_free (priv->lut_float);
+        priv->lut_float = g_new (gfloat, n);
+        priv->lut_float_size = n;
+
+        for (guint i = 0; i < n; i++)
+            priv->lut_float[i] = (gfloat) samples[i];
 
-    g_signal_emit (points, egg_data_points_signals[POINT_REMOVED], 0, index);
+        g_free (samples);
+    }
+
+    return priv->lut_float;
 }
 
-guint
-egg_data_points_get_num (EggDataPoints *points)
+/*
+ * Simplification works on copies of the coordinates and marks the points to
+ * keep. Both methods split the curve into intervals whose end points are
+ * kept and that are simplified independently, one at a time by each thread.
+ */
+typedef struct
 {
-    g_return_val_if_fail (EGG_IS_DATA_POINTS (points), 0);
-    return points->priv->x_adjustments->len;
+    const gdouble   *xs;
+    const gdouble   *ys;
+    guint8          *keep;
+    gdouble          tolerance;
+    EggSimplifyMethod method;
+
+    /* Visvalingam state, each interval only touches its own interior. The
+     * error of a point bounds the distance of the original points from the
+     * segment that starts at it. */
+    guint           *prev;
+    guint           *next;
+    gdouble         *error;
+    guint           *heap_pos;
+
+    guint           *intervals;
+} SimplifyJob;
+
+/* Vertical distance of point @j from the segment between @a and @b */
+static inline gdouble
+vertical_error (const SimplifyJob *job, guint a, guint b, guint j)
+{
+    const gdouble *xs = job->xs;
+    const gdouble *ys = job->ys;
+    gdouble dx = xs[b] - xs[a];
+
+    /* A vertical step is only skipped if it is within the tolerance */
+    if (dx <= 0.0)
+        return MAX (fabs (ys[j] - ys[a]), fabs (ys[j] - ys[b]));
+
+    return fabs (ys[a] + (xs[j] - xs[a]) * (ys[b] - ys[a]) / dx - ys[j]);
 }
 
-GtkAdjustment *
-egg_data_points_get_x (EggDataPoints *data_points,
-                       guint          index)
+/* Find the point in (@a, @b) farthest from the segment, G_MAXUINT if none */
+static guint
+find_farthest (const SimplifyJob *job, guint a, guint b, gdouble *error)
 {
-    EggDataPointsPrivate *priv;
+    guint farthest = G_MAXUINT;
 
-    g_return_val_if_fail (EGG_IS_DATA_POINTS (data_points), NULL);
+    *error = -1.0;
 
-    priv = EGG_DATA_POINTS_GET_PRIVATE (data_points);
-    g_return_val_if_fail (index < priv->x_adjustments->len, NULL);
+    for (guint j = a + 1; j < b; j++) {
+        gdouble e = vertical_error (job, a, b, j);
+
+        if (e > *error) {
+            *error = e;
+            farthest = j;
+        }
+    }
 
-    return GTK_ADJUSTMENT (g_ptr_array_index (priv->x_adjustments, index));
+    return farthest;
 }
 
-GtkAdjustment *
-egg_data_points_get_y (EggDataPoints *data_points,
-                       guint          index)
+/* Keep the points in (@a, @b) that Ramer-Douglas-Peucker needs */
+static void
+simplify_rdp (SimplifyJob *job, guint a, guint b)
 {
-    EggDataPointsPrivate *priv;
+    GArray *stack = g_array_new (FALSE, FALSE, sizeof (guint));
 
-    g_return_val_if_fail (EGG_IS_DATA_POINTS (data_points), NULL);
+    /* Iterative, as the recursion can be as deep as the curve is long */
+    g_array_append_val (stack, a);
+    g_array_append_val (stack, b);
 
-    priv = EGG_DATA_POINTS_GET_PRIVATE (data_points);
-    g_return_val_if_fail (index < priv->y_adjustments->len, NULL);
+    while (stack->len > 0) {
+        gdouble error;
+        guint j;
+
+        b = g_array_index (stack, guint, stack->len - 1);
+        a = g_array_index (stack, guint, stack->len - 2);
+        g_array_set_size (stack, stack->len - 2);
+
+        j = find_farthest (job, a, b, &error);
+
+        if (j == G_MAXUINT || error <= job->tolerance)
+            continue;
 
-    return GTK_ADJUSTMENT (g_ptr_array_index (priv->y_adjustments, index));
+        job->keep[j] = 1;
+        g_array_append_val (stack, a);
+        g_array_append_val (stack, j);
+        g_array_append_val (stack, j);
+        g_array_append_val (stack, b);
+    }
+
+    g_array_free (stack, TRUE);
 }
 
-gdouble egg_data_points_get_x_value (EggDataPoints *data_points,
-                                     guint          index)
+static inline gdouble
+triangle_area (const SimplifyJob *job, guint a, guint i, guint b)
 {
-    EggDataPointsPrivate *priv;
-    GtkAdjustment        *adj;
+    const gdouble *xs = job->xs;
+    const gdouble *ys = job->ys;
 
-    g_return_val_if_fail (EGG_IS_DATA_POINTS (data_points), 0.0);
+    return 0.5 * fabs ((xs[a] - xs[i]) * (ys[b] - ys[i]) - (xs[b] - xs[i]) * (ys[a] - ys[i]));
+}
 
-    priv = EGG_DATA_POINTS_GET_PRIVATE (data_points);
-    g_return_val_if_fail (index < priv->x_adjustments->len, 0.0);
+/*
+ * Binary min-heap of points ordered by area. The area is kept in the entry to
+ * avoid a lookup per comparison, heap_pos tracks the slot of each point.
+ */
+typedef struct
+{
+    gdouble area;
+    guint   index;
+} HeapEntry;
 
-    adj = GTK_ADJUSTMENT (g_ptr_array_index (priv->x_adjustments, index));
-    return gtk_adjustment_get_value (adj);
+static inline void
+heap_put (SimplifyJob *job, HeapEntry *heap, guint i, HeapEntry entry)
+{
+    heap[i] = entry;
+    job->heap_pos[entry.index] = i;
 }
 
-gdouble egg_data_points_get_y_value (EggDataPoints *data_points,
-                                     guint          index)
+static void
+heap_sift_down (SimplifyJob *job, HeapEntry *heap, guint n, guint i)
 {
-    EggDataPointsPrivate *priv;
-    GtkAdjustment        *adj;
+    HeapEntry entry = heap[i];
 
-    g_return_val_if_fail (EGG_IS_DATA_POINTS (data_points), 0.0);
+    for (;;) {
+        guint child = 2 * i + 1;
 
-    priv = EGG_DATA_POINTS_GET_PRIVATE (data_points);
-    g_return_val_if_fail (index < priv->y_adjustments->len, 0.0);
+        if (child >= n)
+            break;
 
-    adj = GTK_ADJUSTMENT (g_ptr_array_index (priv->y_adjustments, index));
-    return gtk_adjustment_get_value (adj);
+        if (child + 1 < n && heap[child + 1].area < heap[child].area)
+            child++;
+
+        if (heap[child].area >= entry.area)
+            break;
+
+        heap_put (job, heap, i, heap[child]);
+        i = child;
+    }
+
+    heap_put (job, heap, i, entry);
 }
 
-void
-egg_data_points_set_x (EggDataPoints *data_points,
-                       guint          index,
-                       gdouble        value)
+/* Restore the heap after the area of heap[i] changed */
+static void
+heap_sift (SimplifyJob *job, HeapEntry *heap, guint n, guint i)
 {
-    EggDataPointsPrivate *priv;
-    GtkAdjustment        *adj;
+    HeapEntry entry = heap[i];
 
-    g_return_if_fail (EGG_IS_DATA_POINTS (data_points));
+    while (i > 0 && entry.area < heap[(i - 1) / 2].area) {
+        heap_put (job, heap, i, heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
 
-    priv = EGG_DATA_POINTS_GET_PRIVATE (data_points);
-    g_return_if_fail (index < priv->x_adjustments->len);
+    heap_put (job, heap, i, entry);
+    heap_sift_down (job, heap, n, i);
+}
+
+/*
+ * Remove the points in (@a, @b) in order of their effective area as long as
+ * every original point stays within the tolerance of the segment that
+ * replaces it. A point that would violate it is kept.
+ *
+ * The new segment deviates from the two it replaces by at most the distance
+ * of the removed point, so adding that to their error bounds the new error.
+ * The original points in between are only measured if the bound exceeds the
+ * tolerance.
+ */
+static void
+simplify_visvalingam (SimplifyJob *job, guint a, guint b)
+{
+    HeapEntry *heap;
+    guint n = 0;
+
+    if (b - a < 2)
+        return;
+
+    heap = g_new (HeapEntry, b - a - 1);
+
+    /* Only the interior is linked, the end points are shared with the
+     * neighboring intervals */
+    for (guint i = a + 1; i < b; i++) {
+        job->prev[i] = i - 1;
+        job->next[i] = i + 1;
+        job->error[i] = 0.0;
+        heap[n].area = triangle_area (job, i - 1, i, i + 1);
+        heap[n].index = i;
+        job->heap_pos[i] = n++;
+    }
+
+    job->error[a] = 0.0;
+
+    for (guint i = n / 2; i-- > 0; )
+        heap_sift_down (job, heap, n, i);
 
-    adj = g_ptr_array_index (priv->x_adjustments, index);
-    gtk_adjustment_set_value (adj, value);
+    while (n > 0) {
+        HeapEntry top = heap[0];
+        guint i = top.index;
+        guint p = job->prev[i];
+        guint q = job->next[i];
+        gdouble error;
+
+        /* Popped points keep a heap position of at least n */
+        heap_put (job, heap, 0, heap[--n]);
+        heap_put (job, heap, n, top);
+        heap_sift_down (job, heap, n, 0);
+
+        error = MAX (job->error[p], job->error[i]) + vertical_error (job, p, q, i);
+
+        if (error > job->tolerance) {
+            error = 0.0;
+
+            for (guint j = p + 1; j < q && error <= job->tolerance; j++)
+                error = MAX (error, vertical_error (job, p, q, j));
+
+            if (error > job->tolerance)
+                continue;
+        }
+
+        job->keep[i] = 0;
+        job->error[p] = error;
+
+        /* Neighbors never become less important than the removed point */
+        if (p > a) {
+            job->next[p] = q;
+
+            if (job->heap_pos[p] < n) {
+                heap[job->heap_pos[p]].area = MAX (triangle_area (job, job->prev[p], p, q), top.area);
+                heap_sift (job, heap, n, job->heap_pos[p]);
+            }
+        }
+
+        if (q < b) {
+            job->prev[q] = p;
+
+            if (job->heap_pos[q] < n) {
+                heap[job->heap_pos[q]].area = MAX (triangle_area (job, p, q, job->next[q]), top.area);
+                heap_sift (job, heap, n, job->heap_pos[q]);
+            }
+        }
+    }
+
+    g_free (heap);
 }
 
-void
-egg_data_points_set_y (EggDataPoints *data_points,
-                       guint          index,
-                       gdouble        value)
+static void
+simplify_interval (gpointer data, guint i)
 {
-    EggDataPointsPrivate *priv;
-    GtkAdjustment        *adj;
+    SimplifyJob *job = data;
+    guint a = job->intervals[2 * i];
+    guint b = job->intervals[2 * i + 1];
+
+    if (job->method == EGG_SIMPLIFY_VISVALINGAM)
+        simplify_visvalingam (job, a, b);
+    else
+        simplify_rdp (job, a, b);
+}
 
-    g_return_if_fail (EGG_IS_DATA_POINTS (data_points));
+/*
+ * Split the curve into at least @n_wanted intervals. Ramer-Douglas-Peucker
+ * is run breadth first on the calling thread until there are enough, so the
+ * result does not depend on the split. Visvalingam is cut into even parts
+ * whose borders are kept.
+ */
+static GArray *
+split_intervals (SimplifyJob *job, guint n_points, guint n_wanted)
+{
+    GArray *intervals = g_array_new (FALSE, FALSE, sizeof (guint));
+    guint a = 0;
+    guint b = n_points - 1;
+    guint first;
+
+    if (job->method == EGG_SIMPLIFY_VISVALINGAM) {
+        for (guint k = 0; k < n_wanted; k++) {
+            a = (guint) ((guint64) (n_points - 1) * k / n_wanted);
+            b = (guint) ((guint64) (n_points - 1) * (k + 1) / n_wanted);
+            g_array_append_val (intervals, a);
+            g_array_append_val (intervals, b);
+        }
 
-    priv = EGG_DATA_POINTS_GET_PRIVATE (data_points);
-    g_return_if_fail (index < priv->x_adjustments->len);
+        return intervals;
+    }
+
+    g_array_append_val (intervals, a);
+    g_array_append_val (intervals, b);
+
+    /* Intervals in front of first are done, either split or within the
+     * tolerance */
+    for (first = 0; first < intervals->len && intervals->len - first < 2 * n_wanted; first += 2) {
+        gdouble error;
+        guint j;
+
+        a = g_array_index (intervals, guint, first);
+        b = g_array_index (intervals, guint, first + 1);
+        j = find_farthest (job, a, b, &error);
 
-    adj = g_ptr_array_index (priv->x_adjustments, index);
-    gtk_adjustment_set_value (adj, value);
+        if (j == G_MAXUINT || error <= job->tolerance)
+            continue;
+
+        job->keep[j] = 1;
+        g_array_append_val (intervals, a);
+        g_array_append_val (intervals, j);
+        g_array_append_val (intervals, j);
+        g_array_append_val (intervals, b);
+    }
+
+    g_array_remove_range (intervals, 0, first);
+    return intervals;
 }
 
+/**
+ * egg_data_points_simplify:
+ * @tolerance: largest vertical distance of a removed point from the curve
+ * @method: the algorithm that decides which points to remove
+ * @n_threads: number of threads to use, 0 to use all processors
+ *
+ * Remove points that are not needed for the shape of the curve. Every removed
+ * point stays within @tolerance of the simplified curve in y, i.e.
+ * egg_data_points_evaluate() at its x changes by at most @tolerance. The
+ * first and last point are always kept. Points must be sorted by x as
+ * enforced by the view's "restrict-x" property.
+ *
+ * Ramer-Douglas-Peucker keeps the points farthest from the segments between
+ * points kept so far, taking O(n log n) when the splits are roughly even. Its
+ * worst case is O(n^2): a curve where every split peels off a single point,
+ * e.g. a convex arc sampled ever more densely towards one end with a
+ * tolerance below all deviations, costs one scan of the remaining points
+ * per kept point. Visvalingam-Whyatt removes the points of smallest
+ * effective area first and tends to keep more of the overall shape. It takes
+ * O(n log n) plus a rescan of the points under a candidate segment whenever
+ * their quick error bound exceeds @tolerance, which is rare for smooth data
+ * but can make noisy curves close to tolerance quadratic as well. With several threads it keeps the points where
+ * the curve is split between them. The points are removed within a single
+ * update, so a single "points-changed::" signal is emitted.
+ *
+ * Returns: the number of removed points.
+ */
 guint
-egg_data_get_closest_point (EggDataPoints *points,
-                            gdouble        x,
-                            gdouble        y,
-                            gdouble       *distance)
+egg_data_points_simplify (EggDataPoints     *points,
+                          gdouble            tolerance,
+                          EggSimplifyMethod  method,
+                          guint              n_threads)
 {
     EggDataPointsPrivate *priv;
-    guint   index        = 0;
-    gdouble min_distance = DBL_MAX;
+    SimplifyJob job;
+    GArray     *intervals;
+    gdouble    *xs, *ys;
+    guint       n_points;
+    guint       n_removed = 0;
 
     g_return_val_if_fail (EGG_IS_DATA_POINTS (points), 0);
+    g_return_val_if_fail (tolerance >= 0.0, 0);
+
     priv = EGG_DATA_POINTS_GET_PRIVATE (points);
+    n_points = priv->n_points;
+
+    if (n_points < 3)
+        return 0;
+
+    if (n_threads == 0)
+        n_threads = g_get_num_processors ();
+
+    if (n_points < MIN_PARALLEL_POINTS)
+        n_threads = 1;
+
+    xs = g_new (gdouble, n_points);
+    ys = g_new (gdouble, n_points);
+    egg_data_points_get_values (points, 0, n_points, xs, ys);
+
+    job.xs = xs;
+    job.ys = ys;
+    job.tolerance = tolerance;
+    job.method = method;
+    job.prev = job.next = job.heap_pos = NULL;
+    job.error = NULL;
+
+    if (method == EGG_SIMPLIFY_VISVALINGAM) {
+        job.keep = g_malloc (n_points);
+        memset (job.keep, 1, n_points);
+        job.prev = g_new (guint, n_points);
+        job.next = g_new (guint, n_points);
+        job.error = g_new (gdouble, n_points);
+        job.heap_pos = g_new (guint, n_points);
+    }
+    else {
+        job.keep = g_malloc0 (n_points);
+        job.keep[0] = job.keep[n_points - 1] = 1;
+    }
+
+    /* More intervals than threads even out their different costs */
+    intervals = split_intervals (&job, n_points, n_threads > 1 ? 4 * n_threads : 1);
+    job.intervals = (guint *) intervals->data;
+    egg_parallel_run (simplify_interval, &job, intervals->len / 2, n_threads);
 
-    for (guint i = 0; i < priv->x_adjustments->len; i++) {
-        GtkAdjustment *x_adj;
-        GtkAdjustment *y_adj;
-        gdouble d, xp, yp;
-
-        x_adj = g_ptr_array_index (priv->x_adjustments, i);
-        y_adj = g_ptr_array_index (priv->y_adjustments, i);
-        xp = x - gtk_adjustment_get_value (x_adj);
-        yp = y - gtk_adjustment_get_value (y_adj);
-        xp /= (priv->upper_x - priv->lower_x);
-        yp /= (priv->upper_y - priv->lower_y);
-        d = sqrt (xp*xp + yp*yp);
-
-        if (d < min_distance) {
-            index = i;
-            min_distance = d;
+    /* Remove runs back to front, the gap then moves through the points once */
+    egg_data_points_begin_update (points);
+
+    for (guint end = n_points; end > 0; ) {
+        guint start;
+
+        if (job.keep[end - 1]) {
+            end--;
+            continue;
         }
+
+        for (start = end - 1; start > 0 && !job.keep[start - 1]; start--)
+            ;
+
+        egg_data_points_remove_points (points, start, end - start);
+        n_removed += end - start;
+        end = start;
     }
 
-    *distance = min_distance;
-    return index;
+    egg_data_points_end_update (points);
+
+    g_array_free (intervals, TRUE);
+    g_free (job.keep);
+    g_free (job.prev);
+    g_free (job.next);
+    g_free (job.error);
+    g_free (job.heap_pos);
+    g_free (xs);
+    g_free (ys);
+
+    return n_removed;
 }
 
 static void
-on_value_changed (GtkAdjustment *adjustment, EggDataPoints *points)
+on_x_value_changed (GtkAdjustment *adjustment, EggDataPoints *points)
 {
-    EggDataPointsPrivate *priv = EGG_DATA_POINTS_GET_PRIVATE (points);
+    guint index;
 
-    for (guint i = 0; i < priv->x_adjustments->len; i++) {
-        if (g_ptr_array_index (priv->x_adjustments, i) == adjustment ||
-            g_ptr_array_index (priv->y_adjustments, i) == adjustment) {
-            g_signal_emit (points, egg_data_points_signals[VALUE_CHANGED], 0, i);
-            break;
-        }
-    }
+    if (get_adjustment_index (adjustment, &index))
+        write_value (points, points->priv->x_values, index, gtk_adjustment_get_value (adjustment));
+}
+
+static void
+on_y_value_changed (GtkAdjustment *adjustment, EggDataPoints *points)
+{
+    guint index;
+
+    if (get_adjustment_index (adjustment, &index))
+        write_value (points, points->priv->y_values, index, gtk_adjustment_get_value (adjustment));
 }
 
 static void
@@ -390,21 +2092,27 @@ egg_data_points_get_property (GObject    *object,
 }
 
 static void
-egg_data_points_dispose (GObject *object)
+release_adjustments (EggDataPoints *points, GHashTable *adjustments)
 {
-    EggDataPointsPrivate *priv;
+    GHashTableIter iter;
+    gpointer value;
 
-    priv = EGG_DATA_POINTS_GET_PRIVATE (object);
+    g_hash_table_iter_init (&iter, adjustments);
 
-    for (guint i = 0; i < priv->x_adjustments->len; i++) {
-        GObject *adj;
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+        release_adjustment (points, GTK_ADJUSTMENT (value));
 
-        adj = G_OBJECT (g_ptr_array_index (priv->x_adjustments, i));
-        g_object_unref (adj);
+    g_hash_table_remove_all (adjustments);
+}
 
-        adj = G_OBJECT (g_ptr_array_index (priv->y_adjustments, i));
-        g_object_unref (adj);
-    }
+static void
+egg_data_points_dispose (GObject *object)
+{
+    EggDataPointsPrivate *priv;
+
+    priv = EGG_DATA_POINTS_GET_PRIVATE (object);
+    release_adjustments (EGG_DATA_POINTS (object), priv->x_adjustments);
+    release_adjustments (EGG_DATA_POINTS (object), priv->y_adjustments);
 
     G_OBJECT_CLASS (egg_data_points_parent_class)->dispose (object);
 }
@@ -415,8 +2123,17 @@ egg_data_points_finalize (GObject *object)
     EggDataPointsPrivate *priv;
 
     priv = EGG_DATA_POINTS_GET_PRIVATE (object);
-    g_ptr_array_free (priv->x_adjustments, TRUE);
-    g_ptr_array_free (priv->y_adjustments, TRUE);
+    g_array_free (priv->x_values, TRUE);
+    g_array_free (priv->y_values, TRUE);
+    g_array_free (priv->increments, TRUE);
+    g_hash_table_destroy (priv->x_adjustments);
+    g_hash_table_destroy (priv->y_adjustments);
+    invalidate_tree (priv);
+    invalidate_extrema (priv);
+    invalidate_luts (priv);
+    priv->x_values = NULL;
+    priv->y_values = NULL;
+    priv->increments = NULL;
     priv->x_adjustments = NULL;
     priv->y_adjustments = NULL;
 
@@ -495,6 +2212,21 @@ egg_data_points_class_init (EggDataPointsClass *klass)
                       G_TYPE_NONE,
                       1, G_TYPE_UINT);
 
+    /* Emitted once for bulk changes and closed updates of the points in
+     * [first, last]. Indices beyond egg_data_points_get_num() refer to points
+     * that were removed. */
+    egg_data_points_signals[POINTS_CHANGED] =
+        g_signal_new ("points-changed",
+                      G_TYPE_FROM_CLASS (klass),
+                      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+                      G_STRUCT_OFFSET (EggDataPointsClass, points_changed),
+                      NULL, NULL,
+                      NULL,
+                      G_TYPE_NONE,
+                      2, G_TYPE_UINT, G_TYPE_UINT);
+
+    egg_data_points_index_quark = g_quark_from_static_string ("egg-data-points-index");
+
     g_type_class_add_private (klass, sizeof (EggDataPointsPrivate));
 }
 
@@ -502,6 +2234,9 @@ static void
 egg_data_points_init (EggDataPoints *points)
 {
     points->priv = EGG_DATA_POINTS_GET_PRIVATE (points);
-    points->priv->x_adjustments = g_ptr_array_new ();
-    points->priv->y_adjustments = g_ptr_array_new ();
+    points->priv->x_values = g_array_new (FALSE, FALSE, sizeof (gdouble));
+    points->priv->y_values = g_array_new (FALSE, FALSE, sizeof (gdouble));
+    points->priv->increments = g_array_new (FALSE, FALSE, sizeof (gdouble));
+    points->priv->x_adjustments = g_hash_table_new (g_direct_hash, g_direct_equal);
+    points->priv->y_adjustments = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
@@ -33,6 +33,12 @@ typedef struct _EggDataPoints           EggDataPoints;
 typedef struct _EggDataPointsClass      EggDataPointsClass;
 typedef struct _EggDataPointsPrivate    EggDataPointsPrivate;
 
+typedef enum
+{
+    EGG_SIMPLIFY_RAMER_DOUGLAS_PEUCKER,
+    EGG_SIMPLIFY_VISVALINGAM
+} EggSimplifyMethod;
+
 struct _EggDataPoints
 {
     GObject parent_instance;
@@ -47,6 +53,7 @@ struct _EggDataPointsClass
 
     /* signals */
     void (* point_changed)  (EggDataPoints *view, guint index);
+    void (* points_changed) (EggDataPoints *view, guint first, guint last);
 };
 
 GType             egg_data_points_get_type      (void);
@@ -68,8 +75,38 @@ void              egg_data_points_insert_point  (EggDataPoints *data_points,
                                                  guint          index,
                                                  gdouble        x,
                                                  gdouble        y);
+guint             egg_data_points_insert_sorted (EggDataPoints *data_points,
+                                                 gdouble        x,
+                                                 gdouble        y);
 void              egg_data_points_remove_point  (EggDataPoints *data_points,
                                                  guint          index);
+void              egg_data_points_set_points_from_arrays
+                                                (EggDataPoints *data_points,
+                                                 const gdouble *xs,
+                                                 const gdouble *ys,
+                                                 guint          n);
+void              egg_data_points_append_points (EggDataPoints *data_points,
+                                                 const gdouble *xs,
+                                                 const gdouble *ys,
+                                                 guint          n);
+void              egg_data_points_insert_points (EggDataPoints *data_points,
+                                                 guint          index,
+                                                 const gdouble *xs,
+                                                 const gdouble *ys,
+                                                 guint          n);
+void              egg_data_points_remove_points (EggDataPoints *data_points,
+                                                 guint          index,
+                                                 guint          n);
+void              egg_data_points_begin_update  (EggDataPoints *data_points);
+void              egg_data_points_end_update    (EggDataPoints *data_points);
+guint64           egg_data_points_get_generation
+                                                (EggDataPoints *data_points);
+gboolean          egg_data_points_get_changes_since
+                                                (EggDataPoints *data_points,
+                                                 guint64        generation,
+                                                 guint         *first,
+                                                 guint         *last,
+                                                 gboolean      *structural);
 guint             egg_data_points_get_num       (EggDataPoints *data_points);
 GtkAdjustment   * egg_data_points_get_x         (EggDataPoints *data_points,
                                                  guint          index);
@@ -79,16 +116,59 @@ gdouble           egg_data_points_get_x_value   (EggDataPoints *data_points,
                                                  guint          index);
 gdouble           egg_data_points_get_y_value   (EggDataPoints *data_points,
                                                  guint          index);
+void              egg_data_points_get_y_extrema (EggDataPoints *data_points,
+                                                 guint          first,
+                                                 guint          last,
+                                                 guint         *min_index,
+                                                 guint         *max_index);
+void              egg_data_points_get_values    (EggDataPoints *data_points,
+                                                 guint          first,
+                                                 guint          n,
+                                                 gdouble       *xs,
+                                                 gdouble       *ys);
 void              egg_data_points_set_x         (EggDataPoints *data_points,
                                                  guint          index,
                                                  gdouble        value);
 void              egg_data_points_set_y         (EggDataPoints *data_points,
                                                  guint          index,
                                                  gdouble        value);
+gdouble           egg_data_points_evaluate      (EggDataPoints *data_points,
+                                                 gdouble        x);
+void              egg_data_points_evaluate_many (EggDataPoints *data_points,
+                                                 const gdouble *in,
+                                                 gdouble       *out,
+                                                 gsize          n);
+guint             egg_data_points_simplify      (EggDataPoints *data_points,
+                                                 gdouble        tolerance,
+                                                 EggSimplifyMethod method,
+                                                 guint          n_threads);
+const guint8    * egg_data_points_bake_lut_u8   (EggDataPoints *data_points);
+const guint16   * egg_data_points_bake_lut_u16  (EggDataPoints *data_points);
+const gfloat    * egg_data_points_bake_lut_float
+                                                (EggDataPoints *data_points,
+                                                 guint          n);
 guint             egg_data_get_closest_point    (EggDataPoints *data_points,
                                                  gdouble        x,
                                                  gdouble        y,
                                                  gdouble       *distance);
+guint             egg_data_points_get_closest_points
+                                                (EggDataPoints *data_points,
+                                                 gdouble        x,
+                                                 gdouble        y,
+                                                 guint          k,
+                                                 guint         *indices,
+                                                 gdouble       *distances);
+void              egg_data_points_find_points_in_radius
+                                                (EggDataPoints *data_points,
+                                                 gdouble        x,
+                                                 gdouble        y,
+                                                 gdouble        radius,
+                                                 GArray        *indices);
+GArray          * egg_data_points_get_points_in_radius
+                                                (EggDataPoints *data_points,
+                                                 gdouble        x,
+                                                 gdouble        y,
+                                                 gdouble        radius);
 
 G_END_DECLS
 
@@ -0,0 +1,829 @@
+/* Copyright (C) 2011, 2012 Matthias Vogelgesang <matthias.vogelgesang@kit.edu>
+   (Karlsruhe Institute of Technology)
+
+   This library is free software; you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by the
+   Free Software Foundation; either version 2.1 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+   details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with this library; if not, write to the Free Software Foundation, Inc., 51
+   Franklin St, Fifth Floor, Boston, MA 02110, USA */
+
+/*
+ * A bucketed k-d tree over point indices. The split planes are fixed when the
+ * tree is built, points are kept in small buckets at the leaves so that moving,
+ * inserting and removing a point only touches one or two buckets. When buckets
+ * grow too unbalanced the tree rebuilds itself from its own items on the next
+ * query.
+ *
+ * All buckets share one array of items, each bucket owns a slice of it with
+ * some room to grow. A bucket that outgrows its slice moves to the end of the
+ * array, the tree is rebuilt once more than half of the array is abandoned.
+ * Every node also keeps the bounding box of the items below it. Queries
+ * allocate nothing and skip subtrees by the distance to their box, which
+ * unlike the distance to a split plane also rules out the empty space around
+ * the data. Boxes grow when items are added and only shrink on rebuilds.
+ *
+ * Inserting or removing a point in the middle shifts the indices of all later
+ * points. Rather than renumbering every item, each item keeps the index it was
+ * added with and the length of a short log of such shifts at that time. The
+ * shifts logged since are applied whenever an index is reported or compared,
+ * and items are only renumbered once the log is full.
+ *
+ * Coordinates are mapped with (x - origin) * scale before they are stored, all
+ * distances are measured in that space.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "egg-kd-tree.h"
+
+#define BUCKET_SIZE         8
+#define MIN_REBUILD_SIZE    (8 * BUCKET_SIZE)
+#define MAX_SHIFTS          64
+
+typedef struct
+{
+    guint   index;
+    guint   n_shifts;
+    gdouble u, v;
+} Item;
+
+/* Indices from @position on moved by @delta */
+typedef struct
+{
+    guint   position;
+    gint    delta;
+} Shift;
+
+typedef struct
+{
+    gdouble min_u, max_u;
+    gdouble min_v, max_v;
+} Box;
+
+typedef struct
+{
+    guint   start;
+    guint   len;
+    guint   allocated;
+} Bucket;
+
+struct _EggKdTree
+{
+    gdouble  x_origin, x_scale;
+    gdouble  y_origin, y_scale;
+
+    guint    depth;
+    gdouble *splits;
+    guint8  *axes;
+    Bucket  *buckets;
+    Box     *boxes;
+
+    Item    *items;
+    guint    items_len;
+    guint    items_allocated;
+    guint    abandoned;
+
+    Shift    shifts[MAX_SHIFTS];
+    guint    n_shifts;
+
+    guint    n_items;
+    guint    built_items;
+    guint    rebuild_size;
+    gboolean needs_rebuild;
+};
+
+typedef struct
+{
+    EggKdTree *tree;
+    guint      first_leaf;
+    gdouble    u, v;
+    guint      k;
+    guint      found;
+    guint     *indices;
+    gdouble   *distances;
+} Query;
+
+EggKdTree *
+egg_kd_tree_new (gdouble x_origin,
+                 gdouble x_scale,
+                 gdouble y_origin,
+                 gdouble y_scale)
+{
+    EggKdTree *tree;
+
+    tree = g_new0 (EggKdTree, 1);
+    tree->x_origin = x_origin;
+    tree->x_scale  = x_scale;
+    tree->y_origin = y_origin;
+    tree->y_scale  = y_scale;
+    tree->rebuild_size = MIN_REBUILD_SIZE;
+
+    return tree;
+}
+
+static void
+free_nodes (EggKdTree *tree)
+{
+    g_free (tree->items);
+    g_free (tree->buckets);
+    g_free (tree->boxes);
+    g_free (tree->splits);
+    g_free (tree->axes);
+    tree->items = NULL;
+    tree->buckets = NULL;
+    tree->boxes = NULL;
+    tree->splits = NULL;
+    tree->axes = NULL;
+}
+
+void
+egg_kd_tree_free (EggKdTree *tree)
+{
+    free_nodes (tree);
+    g_free (tree);
+}
+
+static inline gdouble
+item_coord (const Item *item, guint axis)
+{
+    return axis == 0 ? item->u : item->v;
+}
+
+/* The current index of @item */
+static inline guint
+item_index (const EggKdTree *tree, const Item *item)
+{
+    guint index = item->index;
+
+    for (guint i = item->n_shifts; i < tree->n_shifts; i++) {
+        if (index >= tree->shifts[i].position)
+            index += tree->shifts[i].delta;
+    }
+
+    return index;
+}
+
+static guint
+locate_leaf (EggKdTree *tree, gdouble u, gdouble v)
+{
+    guint node = 0;
+    guint first_leaf = (1 << tree->depth) - 1;
+
+    while (node < first_leaf) {
+        gdouble c = tree->axes[node] == 0 ? u : v;
+        node = 2 * node + (c < tree->splits[node] ? 1 : 2);
+    }
+
+    return node - first_leaf;
+}
+
+static Bucket *
+locate_bucket (EggKdTree *tree, gdouble u, gdouble v)
+{
+    return &tree->buckets[locate_leaf (tree, u, v)];
+}
+
+static inline void
+box_add (Box *box, gdouble u, gdouble v)
+{
+    box->min_u = MIN (box->min_u, u);
+    box->max_u = MAX (box->max_u, u);
+    box->min_v = MIN (box->min_v, v);
+    box->max_v = MAX (box->max_v, v);
+}
+
+/* Squared distance from (u, v) to the box, infinite for an empty box */
+static inline gdouble
+box_distance (const Box *box, gdouble u, gdouble v)
+{
+    gdouble du = MAX (MAX (box->min_u - u, u - box->max_u), 0.0);
+    gdouble dv = MAX (MAX (box->min_v - v, v - box->max_v), 0.0);
+
+    return du * du + dv * dv;
+}
+
+/* Grow the boxes on the path to the bucket of (u, v) */
+static void
+grow_boxes (EggKdTree *tree, gdouble u, gdouble v)
+{
+    guint node = 0;
+    guint first_leaf = (1 << tree->depth) - 1;
+
+    while (node < first_leaf) {
+        gdouble c = tree->axes[node] == 0 ? u : v;
+
+        box_add (&tree->boxes[node], u, v);
+        node = 2 * node + (c < tree->splits[node] ? 1 : 2);
+    }
+
+    box_add (&tree->boxes[node], u, v);
+}
+
+static void
+compute_boxes (EggKdTree *tree)
+{
+    guint first_leaf = (1 << tree->depth) - 1;
+
+    for (guint i = 0; i <= first_leaf; i++) {
+        const Bucket *bucket = &tree->buckets[i];
+        const Item *items = tree->items + bucket->start;
+        Box *box = &tree->boxes[first_leaf + i];
+
+        box->min_u = box->min_v = G_MAXDOUBLE;
+        box->max_u = box->max_v = -G_MAXDOUBLE;
+
+        for (guint j = 0; j < bucket->len; j++)
+            box_add (box, items[j].u, items[j].v);
+    }
+
+    for (guint node = first_leaf; node-- > 0;) {
+        const Box *left = &tree->boxes[2 * node + 1];
+        const Box *right = &tree->boxes[2 * node + 2];
+        Box *box = &tree->boxes[node];
+
+        box->min_u = MIN (left->min_u, right->min_u);
+        box->max_u = MAX (left->max_u, right->max_u);
+        box->min_v = MIN (left->min_v, right->min_v);
+        box->max_v = MAX (left->max_v, right->max_v);
+    }
+}
+
+static void
+bucket_add (EggKdTree *tree, Bucket *bucket, guint index, gdouble u, gdouble v)
+{
+    Item *item;
+
+    if (bucket->len == bucket->allocated) {
+        guint allocated = MAX (BUCKET_SIZE, 2 * bucket->allocated);
+
+        /* Move the bucket to the end of the shared array */
+        if (tree->items_len + allocated > tree->items_allocated) {
+            tree->items_allocated = MAX (2 * tree->items_allocated, tree->items_len + allocated);
+            tree->items = g_renew (Item, tree->items, tree->items_allocated);
+        }
+
+        memcpy (tree->items + tree->items_len, tree->items + bucket->start,
+                bucket->len * sizeof (Item));
+        tree->abandoned += bucket->allocated;
+        bucket->start = tree->items_len;
+        bucket->allocated = allocated;
+        tree->items_len += allocated;
+    }
+
+    item = &tree->items[bucket->start + bucket->len];
+    item->index = index;
+    item->n_shifts = tree->n_shifts;
+    item->u = u;
+    item->v = v;
+    bucket->len++;
+}
+
+static gboolean
+bucket_remove (EggKdTree *tree, Bucket *bucket, guint index)
+{
+    Item *items = tree->items + bucket->start;
+
+    for (guint i = 0; i < bucket->len; i++) {
+        if (item_index (tree, &items[i]) == index) {
+            items[i] = items[--bucket->len];
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/* Partially sort items so that items[k] is in its sorted position on axis */
+static void
+select_nth (Item *items, gint n, gint k, guint axis)
+{
+    gint lo = 0;
+    gint hi = n - 1;
+
+    while (lo < hi) {
+        gdouble pivot = item_coord (&items[k], axis);
+        gint i = lo;
+        gint j = hi;
+
+        do {
+            while (item_coord (&items[i], axis) < pivot)
+                i++;
+
+            while (pivot < item_coord (&items[j], axis))
+                j--;
+
+            if (i <= j) {
+                Item tmp = items[i];
+                items[i] = items[j];
+                items[j] = tmp;
+                i++;
+                j--;
+            }
+        } while (i <= j);
+
+        if (j < k)
+            lo = i;
+
+        if (k < i)
+            hi = j;
+    }
+}
+
+static void
+build_node (EggKdTree *tree, guint node, Item *items, guint n, guint level)
+{
+    gdouble min_u = G_MAXDOUBLE, max_u = -G_MAXDOUBLE;
+    gdouble min_v = G_MAXDOUBLE, max_v = -G_MAXDOUBLE;
+    guint axis;
+    guint mid;
+
+    if (level == tree->depth)
+        return;
+
+    for (guint i = 0; i < n; i++) {
+        min_u = MIN (min_u, items[i].u);
+        max_u = MAX (max_u, items[i].u);
+        min_v = MIN (min_v, items[i].v);
+        max_v = MAX (max_v, items[i].v);
+    }
+
+    axis = (max_u - min_u) >= (max_v - min_v) ? 0 : 1;
+    tree->axes[node] = axis;
+
+    if (n == 0) {
+        tree->splits[node] = 0.0;
+        build_node (tree, 2 * node + 1, items, 0, level + 1);
+        build_node (tree, 2 * node + 2, items, 0, level + 1);
+        return;
+    }
+
+    mid = n / 2;
+    select_nth (items, n, mid, axis);
+    tree->splits[node] = item_coord (&items[mid], axis);
+
+    build_node (tree, 2 * node + 1, items, mid, level + 1);
+    build_node (tree, 2 * node + 2, items + mid, n - mid, level + 1);
+}
+
+static void
+build_from_items (EggKdTree *tree, Item *items, guint n)
+{
+    guint n_buckets;
+    guint largest = 0;
+    guint *leaves;
+    guint start = 0;
+
+    free_nodes (tree);
+
+    tree->depth = 0;
+
+    while ((n >> tree->depth) > BUCKET_SIZE)
+        tree->depth++;
+
+    n_buckets = 1 << tree->depth;
+    tree->splits  = g_new (gdouble, n_buckets);
+    tree->axes    = g_new0 (guint8, n_buckets);
+    tree->buckets = g_new0 (Bucket, n_buckets);
+    tree->boxes   = g_new (Box, 2 * n_buckets - 1);
+
+    build_node (tree, 0, items, n, 0);
+
+    /* Fill buckets by descending, so that lookups agree on ties */
+    leaves = g_new (guint, MAX (n, 1));
+
+    for (guint i = 0; i < n; i++) {
+        leaves[i] = locate_leaf (tree, items[i].u, items[i].v);
+        tree->buckets[leaves[i]].allocated++;
+    }
+
+    for (guint i = 0; i < n_buckets; i++) {
+        Bucket *bucket = &tree->buckets[i];
+
+        largest = MAX (largest, bucket->allocated);
+        bucket->start = start;
+        bucket->allocated += BUCKET_SIZE / 2;
+        start += bucket->allocated;
+    }
+
+    tree->items = g_new (Item, start);
+    tree->items_len = start;
+    tree->items_allocated = start;
+    tree->abandoned = 0;
+
+    for (guint i = 0; i < n; i++) {
+        Bucket *bucket = &tree->buckets[leaves[i]];
+        tree->items[bucket->start + bucket->len++] = items[i];
+    }
+
+    g_free (leaves);
+    compute_boxes (tree);
+
+    tree->n_items = n;
+    tree->built_items = n;
+    tree->rebuild_size = MAX (MIN_REBUILD_SIZE, 4 * largest);
+    tree->needs_rebuild = FALSE;
+}
+
+void
+egg_kd_tree_build (EggKdTree     *tree,
+                   const gdouble *xs,
+                   const gdouble *ys,
+                   guint          n)
+{
+    Item *items;
+
+    items = g_new (Item, MAX (n, 1));
+
+    for (guint i = 0; i < n; i++) {
+        items[i].index = i;
+        items[i].n_shifts = 0;
+        items[i].u = (xs[i] - tree->x_origin) * tree->x_scale;
+        items[i].v = (ys[i] - tree->y_origin) * tree->y_scale;
+    }
+
+    tree->n_shifts = 0;
+    build_from_items (tree, items, n);
+    g_free (items);
+}
+
+static void
+rebuild (EggKdTree *tree)
+{
+    guint n_buckets = 1 << tree->depth;
+    Item *items;
+    guint n = 0;
+
+    items = g_new (Item, MAX (tree->n_items, 1));
+
+    for (guint i = 0; i < n_buckets; i++) {
+        Bucket *bucket = &tree->buckets[i];
+
+        memcpy (items + n, tree->items + bucket->start, bucket->len * sizeof (Item));
+        n += bucket->len;
+    }
+
+    build_from_items (tree, items, n);
+    g_free (items);
+}
+
+static void
+check_balance (EggKdTree *tree, Bucket *bucket)
+{
+    if (bucket->len > tree->rebuild_size ||
+        tree->n_items > 2 * tree->built_items + MIN_REBUILD_SIZE ||
+        tree->abandoned > tree->items_len / 2 + MIN_REBUILD_SIZE)
+        tree->needs_rebuild = TRUE;
+}
+
+/* Apply all logged shifts to the items and clear the log */
+static void
+renumber (EggKdTree *tree)
+{
+    Shift pieces[MAX_SHIFTS + 1];
+    guint n_pieces = 1;
+    guint n_buckets = 1 << tree->depth;
+
+    /* Most items have seen the whole log. For them it composes into offsets
+     * that are constant between at most one position per shift. */
+    pieces[0].position = 0;
+    pieces[0].delta = 0;
+
+    for (guint i = 0; i < tree->n_shifts; i++) {
+        gint64 position = tree->shifts[i].position;
+        gint64 first = 0;
+        guint j;
+
+        /* The first index that is moved to @position or behind it */
+        for (j = 0; j < n_pieces; j++) {
+            first = MAX ((gint64) pieces[j].position, position - pieces[j].delta);
+
+            if (j + 1 == n_pieces || first < pieces[j + 1].position)
+                break;
+        }
+
+        if (first > pieces[j].position) {
+            memmove (pieces + j + 2, pieces + j + 1, (n_pieces - j - 1) * sizeof (Shift));
+            pieces[j + 1].position = (guint) first;
+            pieces[j + 1].delta = pieces[j].delta;
+            n_pieces++;
+            j++;
+        }
+
+        for (; j < n_pieces; j++)
+            pieces[j].delta += tree->shifts[i].delta;
+    }
+
+    for (guint i = 0; i < n_buckets; i++) {
+        Item *items = tree->items + tree->buckets[i].start;
+
+        for (guint j = 0; j < tree->buckets[i].len; j++) {
+            if (items[j].n_shifts == 0) {
+                guint lo = 0;
+                guint hi = n_pieces - 1;
+
+                while (lo < hi) {
+                    guint mid = (lo + hi + 1) / 2;
+
+                    if (pieces[mid].position <= items[j].index)
+                        lo = mid;
+                    else
+                        hi = mid - 1;
+                }
+
+                items[j].index += pieces[lo].delta;
+            }
+            else {
+                items[j].index = item_index (tree, &items[j]);
+                items[j].n_shifts = 0;
+            }
+        }
+    }
+
+    tree->n_shifts = 0;
+}
+
+static void
+shift_indices (EggKdTree *tree, guint position, gint delta)
+{
+    if (tree->n_shifts == MAX_SHIFTS)
+        renumber (tree);
+
+    tree->shifts[tree->n_shifts].position = position;
+    tree->shifts[tree->n_shifts].delta = delta;
+    tree->n_shifts++;
+}
+
+/**
+ * egg_kd_tree_insert:
+ *
+ * Add a point at @index, the indices of the points from @index on grow by
+ * one. Inserting in the middle costs the same as appending.
+ */
+void
+egg_kd_tree_insert (EggKdTree *tree,
+                    guint      index,
+                    gdouble    x,
+                    gdouble    y)
+{
+    Bucket *bucket;
+    gdouble u, v;
+
+    if (tree->buckets == NULL)
+        build_from_items (tree, NULL, 0);
+
+    u = (x - tree->x_origin) * tree->x_scale;
+    v = (y - tree->y_origin) * tree->y_scale;
+
+    if (index < tree->n_items)
+        shift_indices (tree, index, 1);
+
+    bucket = locate_bucket (tree, u, v);
+    bucket_add (tree, bucket, index, u, v);
+    grow_boxes (tree, u, v);
+    tree->n_items++;
+    check_balance (tree, bucket);
+}
+
+/**
+ * egg_kd_tree_remove:
+ *
+ * Remove the point at @index which must be located at (@x, @y), the indices
+ * of the points behind it shrink by one.
+ */
+void
+egg_kd_tree_remove (EggKdTree *tree,
+                    guint      index,
+                    gdouble    x,
+                    gdouble    y)
+{
+    Bucket *bucket;
+
+    g_return_if_fail (tree->buckets != NULL);
+
+    bucket = locate_bucket (tree,
+                            (x - tree->x_origin) * tree->x_scale,
+                            (y - tree->y_origin) * tree->y_scale);
+
+    if (!bucket_remove (tree, bucket, index)) {
+        g_warning ("Point %u not found at (%f, %f)", index, x, y);
+        return;
+    }
+
+    tree->n_items--;
+
+    if (index < tree->n_items)
+        shift_indices (tree, index + 1, -1);
+}
+
+void
+egg_kd_tree_move (EggKdTree *tree,
+                  guint      index,
+                  gdouble    old_x,
+                  gdouble    old_y,
+                  gdouble    x,
+                  gdouble    y)
+{
+    Bucket *from;
+    Bucket *to;
+    gdouble u, v;
+
+    g_return_if_fail (tree->buckets != NULL);
+
+    u = (x - tree->x_origin) * tree->x_scale;
+    v = (y - tree->y_origin) * tree->y_scale;
+
+    from = locate_bucket (tree,
+                          (old_x - tree->x_origin) * tree->x_scale,
+                          (old_y - tree->y_origin) * tree->y_scale);
+    to = locate_bucket (tree, u, v);
+
+    if (from == to) {
+        Item *items = tree->items + from->start;
+
+        for (guint i = 0; i < from->len; i++) {
+            if (item_index (tree, &items[i]) == index) {
+                items[i].u = u;
+                items[i].v = v;
+                grow_boxes (tree, u, v);
+                return;
+            }
+        }
+    }
+    else if (bucket_remove (tree, from, index)) {
+        bucket_add (tree, to, index, u, v);
+        grow_boxes (tree, u, v);
+        check_balance (tree, to);
+        return;
+    }
+
+    g_warning ("Point %u not found at (%f, %f)", index, old_x, old_y);
+}
+
+static void
+query_bucket (Query *query, const Bucket *bucket)
+{
+    const Item *items = query->tree->items + bucket->start;
+
+    for (guint i = 0; i < bucket->len; i++) {
+        gdouble du = items[i].u - query->u;
+        gdouble dv = items[i].v - query->v;
+        gdouble d = du * du + dv * dv;
+        guint pos;
+
+        if (query->found == query->k && d >= query->distances[query->k - 1])
+            continue;
+
+        /* Insertion into the sorted list of the k best candidates */
+        pos = query->found < query->k ? query->found++ : query->k - 1;
+
+        while (pos > 0 && query->distances[pos - 1] > d) {
+            query->distances[pos] = query->distances[pos - 1];
+            query->indices[pos] = query->indices[pos - 1];
+            pos--;
+        }
+
+        query->distances[pos] = d;
+        query->indices[pos] = item_index (query->tree, &items[i]);
+    }
+}
+
+static void
+query_nearest (Query *query, guint node)
+{
+    EggKdTree *tree = query->tree;
+    guint near, far;
+    gdouble near_distance, far_distance;
+
+    if (node >= query->first_leaf) {
+        query_bucket (query, &tree->buckets[node - query->first_leaf]);
+        return;
+    }
+
+    near = 2 * node + 1;
+    far  = 2 * node + 2;
+    near_distance = box_distance (&tree->boxes[near], query->u, query->v);
+    far_distance  = box_distance (&tree->boxes[far], query->u, query->v);
+
+    if (far_distance < near_distance) {
+        guint tmp = near;
+        gdouble d = near_distance;
+
+        near = far;
+        far = tmp;
+        near_distance = far_distance;
+        far_distance = d;
+    }
+
+    if (query->found < query->k || near_distance < query->distances[query->k - 1])
+        query_nearest (query, near);
+
+    if (query->found < query->k || far_distance < query->distances[query->k - 1])
+        query_nearest (query, far);
+}
+
+/**
+ * egg_kd_tree_nearest:
+ *
+ * Find up to @k points closest to (@x, @y) and store their indices and
+ * distances ordered by increasing distance.
+ *
+ * Returns: the number of points found.
+ */
+guint
+egg_kd_tree_nearest (EggKdTree *tree,
+                     gdouble    x,
+                     gdouble    y,
+                     guint      k,
+                     guint     *indices,
+                     gdouble   *distances)
+{
+    Query query;
+
+    if (tree->needs_rebuild)
+        rebuild (tree);
+
+    if (k == 0 || tree->n_items == 0)
+        return 0;
+
+    query.tree = tree;
+    query.first_leaf = (1 << tree->depth) - 1;
+    query.u = (x - tree->x_origin) * tree->x_scale;
+    query.v = (y - tree->y_origin) * tree->y_scale;
+    query.k = k;
+    query.found = 0;
+    query.indices = indices;
+    query.distances = distances;
+
+    query_nearest (&query, 0);
+
+    for (guint i = 0; i < query.found; i++)
+        distances[i] = sqrt (distances[i]);
+
+    return query.found;
+}
+
+static void
+query_within (Query *query, guint node, gdouble radius2, GArray *indices)
+{
+    EggKdTree *tree = query->tree;
+
+    if (box_distance (&tree->boxes[node], query->u, query->v) > radius2)
+        return;
+
+    if (node >= query->first_leaf) {
+        const Bucket *bucket = &tree->buckets[node - query->first_leaf];
+        const Item *items = tree->items + bucket->start;
+
+        for (guint i = 0; i < bucket->len; i++) {
+            gdouble du = items[i].u - query->u;
+            gdouble dv = items[i].v - query->v;
+
+            if (du * du + dv * dv <= radius2) {
+                guint index = item_index (tree, &items[i]);
+                g_array_append_val (indices, index);
+            }
+        }
+
+        return;
+    }
+
+    query_within (query, 2 * node + 1, radius2, indices);
+    query_within (query, 2 * node + 2, radius2, indices);
+}
+
+/**
+ * egg_kd_tree_within:
+ *
+ * Append the indices of all points that are at most @radius away from
+ * (@x, @y) to @indices in no particular order.
+ */
+void
+egg_kd_tree_within (EggKdTree *tree,
+                    gdouble    x,
+                    gdouble    y,
+                    gdouble    radius,
+                    GArray    *indices)
+{
+    Query query;
+
+    if (tree->needs_rebuild)
+        rebuild (tree);
+
+    if (tree->n_items == 0)
+        return;
+
+    query.tree = tree;
+    query.first_leaf = (1 << tree->depth) - 1;
+    query.u = (x - tree->x_origin) * tree->x_scale;
+    query.v = (y - tree->y_origin) * tree->y_scale;
+
+    query_within (&query, 0, radius * radius, indices);
+}
@@ -0,0 +1,64 @@
+/* Copyright (C) 2011, 2012 Matthias Vogelgesang <matthias.vogelgesang@kit.edu>
+   (Karlsruhe Institute of Technology)
+
+   This library is free software; you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by the
+   Free Software Foundation; either version 2.1 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+   details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with this library; if not, write to the Free Software Foundation, Inc., 51
+   Franklin St, Fifth Floor, Boston, MA 02110, USA */
+
+#ifndef EGG_KD_TREE_H
+#define EGG_KD_TREE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _EggKdTree EggKdTree;
+
+EggKdTree * egg_kd_tree_new     (gdouble        x_origin,
+                                 gdouble        x_scale,
+                                 gdouble        y_origin,
+                                 gdouble        y_scale);
+void        egg_kd_tree_free    (EggKdTree     *tree);
+void        egg_kd_tree_build   (EggKdTree     *tree,
+                                 const gdouble *xs,
+                                 const gdouble *ys,
+                                 guint          n);
+void        egg_kd_tree_insert  (EggKdTree     *tree,
+                                 guint          index,
+                                 gdouble        x,
+                                 gdouble        y);
+void        egg_kd_tree_remove  (EggKdTree     *tree,
+                                 guint          index,
+                                 gdouble        x,
+                                 gdouble        y);
+void        egg_kd_tree_move    (EggKdTree     *tree,
+                                 guint          index,
+                                 gdouble        old_x,
+                                 gdouble        old_y,
+                                 gdouble        x,
+                                 gdouble        y);
+guint       egg_kd_tree_nearest (EggKdTree     *tree,
+                                 gdouble        x,
+                                 gdouble        y,
+                                 guint          k,
+                                 guint         *indices,
+                                 gdouble       *distances);
+void        egg_kd_tree_within  (EggKdTree     *tree,
+                                 gdouble        x,
+                                 gdouble        y,
+                                 gdouble        radius,
+                                 GArray        *indices);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,126 @@
+/* Copyright (C) 2011, 2012 Matthias Vogelgesang <matthias.vogelgesang@kit.edu>
+   (Karlsruhe Institute of Technology)
+
+   This library is free software; you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by the
+   Free Software Foundation; either version 2.1 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+   details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with this library; if not, write to the Free Software Foundation, Inc., 51
+   Franklin St, Fifth Floor, Boston, MA 02110, USA */
+
+/*
+ * A shared GThreadPool for the parallel parts of the library. Jobs are
+ * handed out one index at a time, the calling thread takes jobs as well and
+ * returns when all of them are done.
+ */
+
+#include "egg-parallel.h"
+
+typedef struct
+{
+    EggParallelFunc  func;
+    gpointer         data;
+    gint             n_jobs;
+    volatile gint    next_job;
+    volatile gint    running;
+    GMutex           lock;
+    GCond            finished;
+} ParallelRun;
+
+static void
+run_jobs (ParallelRun *run)
+{
+    gint i;
+
+    while ((i = g_atomic_int_add (&run->next_job, 1)) < run->n_jobs)
+        run->func (run->data, i);
+}
+
+static void
+worker (gpointer data, gpointer user_data)
+{
+    ParallelRun *run = data;
+
+    run_jobs (run);
+
+    g_mutex_lock (&run->lock);
+
+    if (--run->running == 0)
+        g_cond_signal (&run->finished);
+
+    g_mutex_unlock (&run->lock);
+}
+
+static GThreadPool *
+get_pool (void)
+{
+    static gsize pool = 0;
+
+    if (g_once_init_enter (&pool)) {
+        GThreadPool *p;
+
+        p = g_thread_pool_new (worker, NULL, g_get_num_processors (), FALSE, NULL);
+        g_once_init_leave (&pool, (gsize) p);
+    }
+
+    return (GThreadPool *) pool;
+}
+
+/**
+ * egg_parallel_run:
+ * @func: called once for every job
+ * @data: passed to @func
+ * @n_jobs: number of jobs, @func receives the indices 0 to @n_jobs - 1
+ * @n_threads: number of threads to use including the calling one, 0 to use
+ * all processors
+ *
+ * Run @n_jobs calls of @func in any order on up to @n_threads threads and
+ * return when all of them are done. @func must not call egg_parallel_run()
+ * itself, the pool threads could all end up waiting.
+ */
+void
+egg_parallel_run (EggParallelFunc  func,
+                  gpointer         data,
+                  guint            n_jobs,
+                  guint            n_threads)
+{
+    ParallelRun run;
+    gint        n_workers;
+
+    g_return_if_fail (func != NULL);
+
+    if (n_threads == 0)
+        n_threads = g_get_num_processors ();
+
+    run.func = func;
+    run.data = data;
+    run.n_jobs = n_jobs;
+    run.next_job = 0;
+
+    n_workers = (gint) MIN (n_threads, n_jobs) - 1;
+    run.running = MAX (n_workers, 0);
+    g_mutex_init (&run.lock);
+    g_cond_init (&run.finished);
+
+    for (gint i = 0; i < n_workers; i++)
+        g_thread_pool_push (get_pool (), &run, NULL);
+
+    run_jobs (&run);
+
+    g_mutex_lock (&run.lock);
+
+    while (run.running > 0)
+        g_cond_wait (&run.finished, &run.lock);
+
+    g_mutex_unlock (&run.lock);
+
+    g_mutex_clear (&run.lock);
+    g_cond_clear (&run.finished);
+}
@@ -0,0 +1,34 @@
+/* Copyright (C) 2011, 2012 Matthias Vogelgesang <matthias.vogelgesang@kit.edu>
+   (Karlsruhe Institute of Technology)
+
+   This library is free software; you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by the
+   Free Software Foundation; either version 2.1 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+   details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with this library; if not, write to the Free Software Foundation, Inc., 51
+   Franklin St, Fifth Floor, Boston, MA 02110, USA */
+
+#ifndef EGG_PARALLEL_H
+#define EGG_PARALLEL_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef void (*EggParallelFunc) (gpointer data, guint index);
+
+void    egg_parallel_run    (EggParallelFunc  func,
+                             gpointer         data,
+                             guint            n_jobs,
+                             guint            n_threads);
+
+G_END_DECLS
+
+#endif
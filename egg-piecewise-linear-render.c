@@ -0,0 +1,877 @@
+/* Copyright (C) 2011, 2012 Matthias Vogelgesang <matthias.vogelgesang@kit.edu>
+   (Karlsruhe Institute of Technology)
+
+   This library is free software; you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by the
+   Free Software Foundation; either version 2.1 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+   details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with this library; if not, write to the Free Software Foundation, Inc., 51
+   Franklin St, Fifth Floor, Boston, MA 02110, USA */
+
+/*
+ * Drawing of a piecewise linear function to any cairo context, without a
+ * window. The view goes through the same two stages: the background is
+ * rendered once into a cached layer, the curve on every expose from the
+ * window positions it keeps between frames.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "egg-piecewise-linear-render.h"
+#include "egg-curve-kernels.h"
+#include "egg-parallel.h"
+
+#define RADIUS          EGG_RENDER_MARKER_RADIUS
+
+/* Prerendered markers have a margin for antialiasing and pixel alignment */
+#define SPRITE_SIZE     (2 * RADIUS + 3)
+
+/* Distance in pixels around the clip area within which points still matter */
+#define PADDING         (RADIUS + 2)
+
+/* Decimate lines when there are more than this many points per pixel column */
+#define M4_THRESHOLD    4
+
+/* Minimum distance in pixels between grid lines of an adaptive grid */
+#define MIN_GRID_SPACING    8.0
+
+/* Length of one dash and gap of the grid lines */
+#define DASH_PERIOD     4.5
+
+/**
+ * egg_render_options_init:
+ *
+ * Fill @options with the defaults of the view: a one-unit grid on both axes
+ * in the colors of the default theme, showing the whole data range.
+ */
+void
+egg_render_options_init (EggRenderOptions *options)
+{
+    static const GdkColor base = { 0, 0xffff, 0xffff, 0xffff };
+    static const GdkColor line = { 0, 0x9c9c, 0x9a9a, 0x9494 };
+    static const GdkColor highlight = { 0, 0x0000, 0x0000, 0x0000 };
+    static const GdkColor selected = { 0, 0x4a4a, 0x9090, 0xd9d9 };
+
+    g_return_if_fail (options != NULL);
+
+    options->border_width = 2;
+    options->grid_x = TRUE;
+    options->grid_y = TRUE;
+    options->grid_x_increment = 1.0;
+    options->grid_y_increment = 1.0;
+    options->adaptive_grid = TRUE;
+    options->marker_density = 0.25;
+    options->base_color = base;
+    options->line_color = line;
+    options->highlight_color = highlight;
+    options->selected_color = selected;
+    options->x_lower = options->x_upper = 0.0;
+    options->y_lower = options->y_upper = 0.0;
+}
+
+/**
+ * egg_render_transform_init:
+ *
+ * Compute the mapping of the visible part of @points onto @width by @height
+ * pixels. Origins are rounded to whole pixels, so that moving the visible
+ * range by whole pixels moves everything by exactly that many pixels.
+ */
+void
+egg_render_transform_init (EggRenderTransform     *transform,
+                           EggDataPoints          *points,
+                           gint                    width,
+                           gint                    height,
+                           const EggRenderOptions *options)
+{
+    gdouble lower_x, upper_x;
+    gdouble lower_y, upper_y;
+    gint    border;
+
+    g_return_if_fail (transform != NULL && options != NULL);
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+
+    egg_data_points_get_x_range (points, &lower_x, &upper_x);
+    egg_data_points_get_y_range (points, &lower_y, &upper_y);
+
+    if (options->x_lower < options->x_upper) {
+        lower_x = options->x_lower;
+        upper_x = options->x_upper;
+    }
+
+    if (options->y_lower < options->y_upper) {
+        lower_y = options->y_lower;
+        upper_y = options->y_upper;
+    }
+
+    border = options->border_width;
+    transform->width    = width;
+    transform->height   = height;
+    transform->x_scale  = (width - 2 * border) / (upper_x - lower_x);
+    transform->x_origin = floor (border - lower_x * transform->x_scale + 0.5);
+    transform->y_scale  = -(height - 2 * border) / (upper_y - lower_y);
+    transform->y_origin = floor (border - upper_y * transform->y_scale + 0.5);
+}
+
+/*
+ * Grow @increment by factors of 1, 2 and 5 until adjacent grid lines are at
+ * least @spacing pixels apart at @scale pixels per unit.
+ */
+static gdouble
+adapt_increment (gdouble increment, gdouble scale, gdouble spacing)
+{
+    static const gdouble steps[3] = { 1.0, 2.0, 5.0 };
+    gdouble decade;
+
+    scale = fabs (scale);
+
+    /* Nothing to see on a collapsed axis */
+    if (!(scale > 0.0) || isinf (scale))
+        return G_MAXDOUBLE;
+
+    if (increment * scale >= spacing)
+        return increment;
+
+    decade = pow (10.0, floor (log10 (spacing / (increment * scale))));
+
+    for (;;) {
+        for (guint i = 0; i < 3; i++) {
+            if (increment * decade * steps[i] * scale >= spacing)
+                return increment * decade * steps[i];
+        }
+
+        decade *= 10.0;
+    }
+}
+
+static gdouble
+dash_offset (gdouble offset)
+{
+    offset = fmod (offset, DASH_PERIOD);
+    return offset < 0.0 ? offset + DASH_PERIOD : offset;
+}
+
+/**
+ * egg_piecewise_linear_render_background:
+ *
+ * Draw the base color, the frame and the visible grid lines to the area
+ * described by @transform. Honors the clip of @cr, so parts of a cached
+ * layer can be repainted.
+ */
+void
+egg_piecewise_linear_render_background (EggDataPoints            *points,
+                                        cairo_t                  *cr,
+                                        const EggRenderTransform *transform,
+                                        const EggRenderOptions   *options)
+{
+    const static gdouble dashes[2] = { 0.5, DASH_PERIOD - 0.5 };
+
+    gint    border;
+    gint    width, height;
+    gdouble lower_x, upper_x;
+    gdouble lower_y, upper_y;
+    gdouble spacing;
+    gdouble first, last;
+
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+    g_return_if_fail (cr != NULL && transform != NULL && options != NULL);
+
+    cairo_save (cr);
+
+    /* Draw the background */
+    gdk_cairo_set_source_color (cr, &options->base_color);
+    cairo_rectangle (cr, 0, 0, transform->width, transform->height);
+    cairo_fill (cr);
+
+    border = options->border_width;
+    width  = transform->width - 2 * border;
+    height = transform->height - 2 * border;
+
+    gdk_cairo_set_source_color (cr, &options->line_color);
+    cairo_set_line_width (cr, 1.0);
+    cairo_set_line_cap (cr, CAIRO_LINE_CAP_SQUARE);
+    cairo_translate (cr, 0.5, 0.5);
+    cairo_rectangle (cr, border, border, width - 1, height - 1);
+    cairo_stroke (cr);
+
+    /* Grid lines are anchored at the lower bounds of the data */
+    egg_data_points_get_x_range (points, &lower_x, &upper_x);
+    egg_data_points_get_y_range (points, &lower_y, &upper_y);
+
+    /* Draw grid lines i * increment above the lower bound, for those i that
+     * fall into the visible part */
+    spacing = options->adaptive_grid ? MIN_GRID_SPACING : 1.0;
+
+    if (options->grid_x && options->grid_x_increment > 0.0) {
+        gdouble increment = adapt_increment (options->grid_x_increment, transform->x_scale, spacing);
+
+        first = MAX (1.0, ceil (((border - transform->x_origin) / transform->x_scale - lower_x) / increment));
+        last  = MIN (ceil ((upper_x - lower_x) / increment) - 1.0,
+                     floor (((transform->width - border - transform->x_origin) / transform->x_scale - lower_x) / increment));
+
+        for (gdouble i = first; i <= last; i++) {
+            gdouble xp = transform->x_origin + transform->x_scale * (lower_x + i * increment);
+            cairo_move_to (cr, floor (xp), border);
+            cairo_line_to (cr, floor (xp), height);
+        }
+
+        /* Anchor the dashes to the data so that they survive scrolling */
+        cairo_set_dash (cr, dashes, 2, dash_offset (border - transform->y_origin));
+        cairo_stroke (cr);
+    }
+
+    if (options->grid_y && options->grid_y_increment > 0.0) {
+        gdouble increment = adapt_increment (options->grid_y_increment, transform->y_scale, spacing);
+
+        first = MAX (1.0, ceil (((transform->height - border - transform->y_origin) / transform->y_scale - lower_y) / increment));
+        last  = MIN (ceil ((upper_y - lower_y) / increment) - 1.0,
+                     floor (((border - transform->y_origin) / transform->y_scale - lower_y) / increment));
+
+        for (gdouble i = first; i <= last; i++) {
+            gdouble yp = transform->y_origin + transform->y_scale * (lower_y + i * increment);
+            cairo_move_to (cr, border, floor (yp));
+            cairo_line_to (cr, width, floor (yp));
+        }
+
+        cairo_set_dash (cr, dashes, 2, dash_offset (border - transform->x_origin));
+        cairo_stroke (cr);
+    }
+
+    cairo_restore (cr);
+}
+
+/*
+ * Clip the segment from (@x0, @y0) to (@x1, @y1) to the rectangle x1, y1, x2,
+ * y2 in @rect with the Liang-Barsky algorithm. Returns FALSE if nothing of the
+ * segment is left.
+ */
+static gboolean
+clip_segment (const gdouble *rect, gdouble *x0, gdouble *y0, gdouble *x1, gdouble *y1)
+{
+    gdouble dx = *x1 - *x0;
+    gdouble dy = *y1 - *y0;
+    gdouble p[4] = { -dx, dx, -dy, dy };
+    gdouble q[4] = { *x0 - rect[0], rect[2] - *x0, *y0 - rect[1], rect[3] - *y0 };
+    gdouble t0 = 0.0;
+    gdouble t1 = 1.0;
+
+    for (guint i = 0; i < 4; i++) {
+        if (p[i] == 0.0) {
+            if (q[i] < 0.0)
+                return FALSE;
+        }
+        else {
+            gdouble t = q[i] / p[i];
+
+            if (p[i] < 0.0)
+                t0 = MAX (t0, t);
+            else
+                t1 = MIN (t1, t);
+
+            if (t0 > t1)
+                return FALSE;
+        }
+    }
+
+    if (t1 < 1.0) {
+        *x1 = *x0 + t1 * dx;
+        *y1 = *y0 + t1 * dy;
+    }
+
+    if (t0 > 0.0) {
+        *x0 += t0 * dx;
+        *y0 += t0 * dy;
+    }
+
+    return TRUE;
+}
+
+static inline guint
+position_slot (const EggRenderPositions *positions, guint index)
+{
+    return index < positions->gap_start ? index : index + positions->gap_size;
+}
+
+static inline gdouble
+position_x (const EggRenderPositions *positions, guint index)
+{
+    return positions->xs[position_slot (positions, index)];
+}
+
+static inline gdouble
+position_y (const EggRenderPositions *positions, guint index)
+{
+    return positions->ys[position_slot (positions, index)];
+}
+
+/* First index in [first, last) with an x position of at least @x, or @last */
+static guint
+positions_lower_bound (const EggRenderPositions *positions, guint first, guint last, gdouble x)
+{
+    guint split = CLAMP (positions->gap_start, first, last);
+    guint index;
+
+    index = first + egg_curve_kernel_lower_bound (positions->xs + first, split - first, x);
+
+    if (index < split)
+        return index;
+
+    return split + egg_curve_kernel_lower_bound (positions->xs + split + positions->gap_size,
+                                                 last - split, x);
+}
+
+/*
+ * Add the segment between the points @from and @to, clipped to @clip, to the
+ * path. @connected tells if the path currently ends at @from.
+ */
+static void
+add_segment (cairo_t *cr, const gdouble *clip, const EggRenderPositions *positions,
+             guint from, guint to, gboolean *connected)
+{
+    gdouble from_x = position_x (positions, from), from_y = position_y (positions, from);
+    gdouble to_x = position_x (positions, to), to_y = position_y (positions, to);
+    gdouble x0 = from_x, y0 = from_y;
+    gdouble x1 = to_x, y1 = to_y;
+
+    if (!clip_segment (clip, &x0, &y0, &x1, &y1)) {
+        *connected = FALSE;
+        return;
+    }
+
+    if (!*connected || x0 != from_x || y0 != from_y)
+        cairo_move_to (cr, x0, y0);
+
+    cairo_line_to (cr, x1, y1);
+    *connected = x1 == to_x && y1 == to_y;
+}
+
+/*
+ * Add the segments of the sorted points in [first, last) to the path, using
+ * only the first, last, lowest and highest point of each pixel column (M4).
+ * The result rasterizes exactly like the full polyline.
+ */
+static void
+add_decimated (EggDataPoints *points, cairo_t *cr, const gdouble *clip,
+               const EggRenderPositions *positions, guint n_points,
+               guint first, guint last, gboolean *connected)
+{
+    guint previous = first > 0 ? first - 1 : G_MAXUINT;
+    guint start = first;
+
+    while (start < last) {
+        guint end = positions_lower_bound (positions, start, last,
+                                           floor (position_x (positions, start)) + 1.0);
+        guint vertices[4];
+        guint n_vertices = 0;
+
+        if (end - start <= 4) {
+            for (guint i = start; i < end; i++)
+                vertices[n_vertices++] = i;
+        }
+        else {
+            guint lowest, highest;
+
+            egg_data_points_get_y_extrema (points, start, end - 1, &lowest, &highest);
+            vertices[0] = start;
+            vertices[1] = MIN (lowest, highest);
+            vertices[2] = MAX (lowest, highest);
+            vertices[3] = end - 1;
+            n_vertices = 4;
+        }
+
+        for (guint i = 0; i < n_vertices; i++) {
+            if (previous != G_MAXUINT && previous != vertices[i])
+                add_segment (cr, clip, positions, previous, vertices[i], connected);
+
+            previous = vertices[i];
+        }
+
+        start = end;
+    }
+
+    if (previous != G_MAXUINT && last < n_points)
+        add_segment (cr, clip, positions, previous, last, connected);
+}
+
+
+/* Number of points per pixel column within the drawing area */
+static gdouble
+marker_density (const EggRenderTransform *transform, const EggRenderPositions *positions,
+                guint n_points, gboolean sorted)
+{
+    guint n_visible = n_points;
+
+    if (sorted)
+        n_visible = positions_lower_bound (positions, 0, n_points, transform->width) -
+                    positions_lower_bound (positions, 0, n_points, 0.0);
+
+    return (gdouble) n_visible / MAX (transform->width, 1);
+}
+
+enum
+{
+    MARKER_POINT,
+    MARKER_SELECTED,
+    MARKER_HIGHLIGHT,
+    N_MARKERS
+};
+
+/*
+ * Marker sprites and the bitmap of covered pixels, kept between calls of
+ * egg_piecewise_linear_render_curve(). A sprite is rendered again when its
+ * color changes, the bitmap only grows.
+ */
+struct _EggRenderCache
+{
+    cairo_surface_t *markers[N_MARKERS];
+    GdkColor         colors[N_MARKERS];
+    guint32         *occupied;
+    gsize            occupied_size;
+};
+
+/**
+ * egg_render_cache_new:
+ *
+ * Create a cache for egg_piecewise_linear_render_curve(). A cache must only
+ * be used by one thread at a time.
+ */
+EggRenderCache *
+egg_render_cache_new (void)
+{
+    return g_new0 (EggRenderCache, 1);
+}
+
+void
+egg_render_cache_free (EggRenderCache *cache)
+{
+    if (cache == NULL)
+        return;
+
+    for (guint i = 0; i < N_MARKERS; i++) {
+        if (cache->markers[i] != NULL)
+            cairo_surface_destroy (cache->markers[i]);
+    }
+
+    g_free (cache->occupied);
+    g_free (cache);
+}
+
+/*
+ * Render a marker once, so that drawing a point is a single blit instead of
+ * rasterizing a circle.
+ */
+static cairo_surface_t *
+get_marker (EggRenderCache *cache, cairo_t *cr, guint kind, const GdkColor *color)
+{
+    cairo_t *marker_cr;
+
+    if (cache->markers[kind] != NULL) {
+        if (gdk_color_equal (&cache->colors[kind], color))
+            return cache->markers[kind];
+
+        cairo_surface_destroy (cache->markers[kind]);
+    }
+
+    cache->markers[kind] = cairo_surface_create_similar (cairo_get_target (cr),
+                                                         CAIRO_CONTENT_COLOR_ALPHA,
+                                                         SPRITE_SIZE, SPRITE_SIZE);
+    cache->colors[kind] = *color;
+
+    marker_cr = cairo_create (cache->markers[kind]);
+    gdk_cairo_set_source_color (marker_cr, color);
+    cairo_arc (marker_cr, SPRITE_SIZE / 2.0, SPRITE_SIZE / 2.0, RADIUS, 0, 2 * G_PI);
+    cairo_fill (marker_cr);
+    cairo_destroy (marker_cr);
+
+    return cache->markers[kind];
+}
+
+/* Pixels of the drawing area that already received a marker */
+typedef struct
+{
+    gint     x, y;
+    gint     width, height;
+    guint32 *occupied;
+} StampArea;
+
+/* Clear @size words of the cached bitmap for @area */
+static void
+clear_area (EggRenderCache *cache, StampArea *area, gsize size)
+{
+    if (size > cache->occupied_size) {
+        g_free (cache->occupied);
+        cache->occupied = g_new (guint32, size);
+        cache->occupied_size = size;
+    }
+
+    memset (cache->occupied, 0, size * sizeof (guint32));
+    area->occupied = cache->occupied;
+}
+
+/*
+ * Mark the pixel at (@x, @y) as covered and store it in @px and @py. Returns
+ * FALSE if it lies outside of @area or already was covered.
+ */
+static gboolean
+occupy_pixel (StampArea *area, gdouble x, gdouble y, gint *px, gint *py)
+{
+    gsize bit;
+
+    *px = (gint) floor (x);
+    *py = (gint) floor (y);
+
+    if (*px < area->x || *py < area->y ||
+        *px >= area->x + area->width || *py >= area->y + area->height)
+        return FALSE;
+
+    bit = (gsize) (*py - area->y) * area->width + (*px - area->x);
+
+    if (area->occupied[bit / 32] & (1u << (bit % 32)))
+        return FALSE;
+
+    area->occupied[bit / 32] |= 1u << (bit % 32);
+    return TRUE;
+}
+
+static void
+stamp_marker (cairo_t *cr, cairo_surface_t *marker, gint x, gint y)
+{
+    x -= SPRITE_SIZE / 2;
+    y -= SPRITE_SIZE / 2;
+    cairo_set_source_surface (cr, marker, x, y);
+    cairo_rectangle (cr, x, y, SPRITE_SIZE, SPRITE_SIZE);
+    cairo_fill (cr);
+}
+
+/**
+ * egg_piecewise_linear_render_curve:
+ * @positions: device positions of all points of @points
+ * @sorted: %TRUE if the x positions are in ascending order
+ * @selected: indices of the selected points in ascending order
+ * @n_selected: number of entries in @selected
+ * @highlight: index of a point to draw highlighted, or %G_MAXUINT
+ * @cache: marker sprites to reuse from earlier calls, or %NULL
+ *
+ * Draw the lines and markers of @points. Only what touches the clip of @cr
+ * is visited: with @sorted, the points in view are found by binary search,
+ * lines are decimated per pixel column when points are dense and at most
+ * one marker is stamped per pixel.
+ */
+void
+egg_piecewise_linear_render_curve (EggDataPoints            *points,
+                                   cairo_t                  *cr,
+                                   const EggRenderTransform *transform,
+                                   const EggRenderOptions   *options,
+                                   const EggRenderPositions *positions,
+                                   gboolean                  sorted,
+                                   const guint              *selected,
+                                   guint                     n_selected,
+                                   guint                     highlight,
+                                   EggRenderCache           *cache)
+{
+    EggRenderCache  *own_cache = NULL;
+    cairo_surface_t *marker;
+    StampArea        area;
+    gsize            area_size;
+    guint            n_points;
+    gdouble          clip[4];
+    guint            first, last;
+    gboolean         connected;
+
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+    g_return_if_fail (cr != NULL && transform != NULL && options != NULL);
+    g_return_if_fail (positions != NULL);
+
+    n_points = egg_data_points_get_num (points);
+    cairo_clip_extents (cr, &clip[0], &clip[1], &clip[2], &clip[3]);
+    clip[0] = MAX (clip[0], 0.0) - PADDING;
+    clip[1] = MAX (clip[1], 0.0) - PADDING;
+    clip[2] = MIN (clip[2], transform->width) + PADDING;
+    clip[3] = MIN (clip[3], transform->height) + PADDING;
+
+    if (clip[0] >= clip[2] || clip[1] >= clip[3])
+        return;
+
+    /* Points in [first, last) lie within the clipped columns */
+    if (sorted) {
+        first = positions_lower_bound (positions, 0, n_points, clip[0]);
+        last  = positions_lower_bound (positions, 0, n_points, clip[2]);
+    }
+    else {
+        first = 0;
+        last  = n_points;
+    }
+
+    /* Draw lines, clipped to the area */
+    cairo_save (cr);
+    gdk_cairo_set_source_color (cr, &options->line_color);
+    cairo_set_line_width (cr, 1.5);
+    cairo_set_line_cap (cr, CAIRO_LINE_CAP_SQUARE);
+    cairo_translate (cr, 0.5, 0.5);
+    connected = FALSE;
+
+    if (sorted && last - first > M4_THRESHOLD * (clip[2] - clip[0]))
+        add_decimated (points, cr, clip, positions, n_points, first, last, &connected);
+    else {
+        for (guint i = MAX (first, 1); i <= MIN (last, n_points - 1); i++)
+            add_segment (cr, clip, positions, i - 1, i, &connected);
+    }
+
+    cairo_stroke (cr);
+    cairo_restore (cr);
+
+    /* Markers would only form a solid band, leave them out. The density is
+     * measured over the whole area so that partial redraws agree. */
+    if (marker_density (transform, positions, n_points, sorted) > options->marker_density)
+        last = first;
+
+    /* Draw points, stamping at most one marker per pixel of the area */
+    area.x = (gint) floor (clip[0]);
+    area.y = (gint) floor (clip[1]);
+    area.width  = (gint) ceil (clip[2]) - area.x;
+    area.height = (gint) ceil (clip[3]) - area.y;
+    area_size   = ((gsize) area.width * area.height + 31) / 32;
+
+    if (cache == NULL)
+        cache = own_cache = egg_render_cache_new ();
+
+    clear_area (cache, &area, area_size);
+    marker = get_marker (cache, cr, MARKER_POINT, &options->line_color);
+
+    for (guint i = first, s = 0; i < last; i++) {
+        gint px, py;
+
+        while (s < n_selected && selected[s] < i)
+            s++;
+
+        if (i == highlight || (s < n_selected && selected[s] == i))
+            continue;
+
+        if (occupy_pixel (&area, position_x (positions, i), position_y (positions, i), &px, &py))
+            stamp_marker (cr, marker, px, py);
+    }
+
+    /* Selected points are shown even where markers are left out */
+    if (n_selected > 0) {
+        clear_area (cache, &area, area_size);
+        marker = get_marker (cache, cr, MARKER_SELECTED, &options->selected_color);
+
+        for (guint s = 0; s < n_selected; s++) {
+            gint px, py;
+
+            if (selected[s] < n_points && selected[s] != highlight &&
+                occupy_pixel (&area, position_x (positions, selected[s]),
+                              position_y (positions, selected[s]), &px, &py))
+                stamp_marker (cr, marker, px, py);
+        }
+    }
+
+    if (highlight < n_points) {
+        marker = get_marker (cache, cr, MARKER_HIGHLIGHT, &options->highlight_color);
+        stamp_marker (cr, marker,
+                      (gint) floor (position_x (positions, highlight)),
+                      (gint) floor (position_y (positions, highlight)));
+    }
+
+    egg_render_cache_free (own_cache);
+}
+
+static void
+render_with_cache (EggDataPoints          *points,
+                   cairo_t                *cr,
+                   gint                    width,
+                   gint                    height,
+                   const EggRenderOptions *options,
+                   EggRenderCache         *cache)
+{
+    EggRenderOptions   defaults;
+    EggRenderTransform transform;
+    EggRenderPositions positions;
+    gdouble           *xs, *ys;
+    guint              n_points;
+    gboolean           sorted = TRUE;
+
+    if (options == NULL) {
+        egg_render_options_init (&defaults);
+        options = &defaults;
+    }
+
+    egg_render_transform_init (&transform, points, width, height, options);
+
+    n_points = egg_data_points_get_num (points);
+    xs = g_new (gdouble, n_points);
+    ys = g_new (gdouble, n_points);
+    egg_data_points_get_values (points, 0, n_points, xs, ys);
+    egg_curve_kernel_linear (xs, xs, n_points, 0.0, transform.x_origin, transform.x_scale);
+    egg_curve_kernel_linear (ys, ys, n_points, 0.0, transform.y_origin, transform.y_scale);
+
+    for (guint i = 1; i < n_points && sorted; i++)
+        sorted = xs[i - 1] <= xs[i];
+
+    positions.xs = xs;
+    positions.ys = ys;
+    positions.gap_start = n_points;
+    positions.gap_size = 0;
+
+    cairo_save (cr);
+    cairo_rectangle (cr, 0, 0, width, height);
+    cairo_clip (cr);
+    egg_piecewise_linear_render_background (points, cr, &transform, options);
+    egg_piecewise_linear_render_curve (points, cr, &transform, options, &positions, sorted,
+                                       NULL, 0, G_MAXUINT, cache);
+    cairo_restore (cr);
+
+    g_free (xs);
+    g_free (ys);
+}
+
+/**
+ * egg_piecewise_linear_render:
+ * @cr: context to draw to, the function draws into (0, 0, @width, @height)
+ * @options: options, or %NULL for the defaults of egg_render_options_init()
+ *
+ * Draw grid, curve and markers of @points like the view does, without
+ * needing a display.
+ */
+void
+egg_piecewise_linear_render (EggDataPoints          *points,
+                             cairo_t                *cr,
+                             gint                    width,
+                             gint                    height,
+                             const EggRenderOptions *options)
+{
+    g_return_if_fail (EGG_IS_DATA_POINTS (points));
+    g_return_if_fail (cr != NULL);
+
+    render_with_cache (points, cr, width, height, options, NULL);
+}
+
+typedef struct
+{
+    EggDataPoints          **points;
+    const gchar * const     *filenames;
+    guint                    n_files;
+    guint                    n_jobs;
+    gint                     width;
+    gint                     height;
+    const EggRenderOptions  *options;
+
+    /* Guards error */
+    GMutex                   lock;
+    GError                  *error;
+} PngJob;
+
+static void
+write_file (PngJob *job, guint i, EggRenderCache *cache)
+{
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    cairo_status_t status;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_RGB24, job->width, job->height);
+    cr = cairo_create (surface);
+    render_with_cache (job->points[i], cr, job->width, job->height, job->options, cache);
+    cairo_destroy (cr);
+
+    status = cairo_surface_write_to_png (surface, job->filenames[i]);
+    cairo_surface_destroy (surface);
+
+    if (status != CAIRO_STATUS_SUCCESS) {
+        g_mutex_lock (&job->lock);
+
+        if (job->error == NULL)
+            g_set_error (&job->error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                         "Could not write `%s': %s",
+                         job->filenames[i], cairo_status_to_string (status));
+
+        g_mutex_unlock (&job->lock);
+    }
+}
+
+/* Write a contiguous share of the files, sharing one set of markers */
+static void
+write_files (gpointer data, guint index)
+{
+    PngJob *job = data;
+    EggRenderCache *cache;
+    guint first = (guint) ((guint64) job->n_files * index / job->n_jobs);
+    guint last  = (guint) ((guint64) job->n_files * (index + 1) / job->n_jobs);
+
+    cache = egg_render_cache_new ();
+
+    for (guint i = first; i < last; i++)
+        write_file (job, i, cache);
+
+    egg_render_cache_free (cache);
+}
+
+/**
+ * egg_piecewise_linear_render_png:
+ * @points: the stores to render
+ * @filenames: one file name per store
+ * @n_files: number of entries in @points and @filenames
+ * @options: options, or %NULL for the defaults of egg_render_options_init()
+ * @n_threads: number of threads to use, 0 to use all processors
+ *
+ * Render each store into a @width by @height PNG file, several files at a
+ * time. The stores must not be modified while this function runs.
+ *
+ * Returns: %TRUE if all files were written. Otherwise @error is set for the
+ * first failure and the remaining files are still written.
+ */
+gboolean
+egg_piecewise_linear_render_png (EggDataPoints          **points,
+                                 const gchar * const     *filenames,
+                                 guint                    n_files,
+                                 gint                     width,
+                                 gint                     height,
+                                 const EggRenderOptions  *options,
+                                 guint                    n_threads,
+                                 GError                 **error)
+{
+    PngJob job;
+
+    g_return_val_if_fail (points != NULL && filenames != NULL, FALSE);
+    g_return_val_if_fail (width > 0 && height > 0, FALSE);
+
+    /* The extrema used for decimation are built on first use, do that here
+     * so that the workers only read from the stores */
+    for (guint i = 0; i < n_files; i++) {
+        guint lowest, highest;
+
+        if (egg_data_points_get_num (points[i]) > 0)
+            egg_data_points_get_y_extrema (points[i], 0, 0, &lowest, &highest);
+    }
+
+    if (n_threads == 0)
+        n_threads = g_get_num_processors ();
+
+    /* Each job renders a share of the files with its own markers. More jobs
+     * than threads even out files of different cost. */
+    job.points = points;
+    job.filenames = filenames;
+    job.n_files = n_files;
+    job.n_jobs = MIN (n_files, 4 * n_threads);
+    job.width = width;
+    job.height = height;
+    job.options = options;
+    job.error = NULL;
+    g_mutex_init (&job.lock);
+
+    egg_parallel_run (write_files, &job, job.n_jobs, n_threads);
+
+    g_mutex_clear (&job.lock);
+
+    if (job.error != NULL) {
+        g_propagate_error (error, job.error);
+        return FALSE;
+    }
+
+    return TRUE;
+}
@@ -0,0 +1,115 @@
+/* Copyright (C) 2011, 2012 Matthias Vogelgesang <matthias.vogelgesang@kit.edu>
+   (Karlsruhe Institute of Technology)
+
+   This library is free software; you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by the
+   Free Software Foundation; either version 2.1 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+   details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with this library; if not, write to the Free Software Foundation, Inc., 51
+   Franklin St, Fifth Floor, Boston, MA 02110, USA */
+
+#ifndef EGG_PIECEWISE_LINEAR_RENDER_H
+#define EGG_PIECEWISE_LINEAR_RENDER_H
+
+#include <gtk/gtk.h>
+#include "egg-data-points.h"
+
+G_BEGIN_DECLS
+
+/* Radius of the marker drawn for each point */
+#define EGG_RENDER_MARKER_RADIUS    3
+
+typedef struct
+{
+    gint        border_width;
+    gboolean    grid_x;
+    gboolean    grid_y;
+    gdouble     grid_x_increment;
+    gdouble     grid_y_increment;
+    gboolean    adaptive_grid;
+    gdouble     marker_density;
+
+    GdkColor    base_color;
+    GdkColor    line_color;
+    GdkColor    highlight_color;
+    GdkColor    selected_color;
+
+    /* Visible part of the data, an empty range shows everything */
+    gdouble     x_lower, x_upper;
+    gdouble     y_lower, y_upper;
+} EggRenderOptions;
+
+typedef struct _EggRenderCache EggRenderCache;
+
+typedef struct
+{
+    gint        width;
+    gint        height;
+
+    /* Device position = origin + scale * data value */
+    gdouble     x_origin, x_scale;
+    gdouble     y_origin, y_scale;
+} EggRenderTransform;
+
+/* Device positions of the points. Like the points in the store they may be
+ * kept with a gap of unused entries: the position of index i is at i before
+ * gap_start and at i + gap_size from there on. */
+typedef struct
+{
+    const gdouble *xs;
+    const gdouble *ys;
+    guint          gap_start;
+    guint          gap_size;
+} EggRenderPositions;
+
+void        egg_render_options_init         (EggRenderOptions         *options);
+EggRenderCache *
+            egg_render_cache_new            (void);
+void        egg_render_cache_free           (EggRenderCache           *cache);
+void        egg_render_transform_init       (EggRenderTransform       *transform,
+                                             EggDataPoints            *points,
+                                             gint                      width,
+                                             gint                      height,
+                                             const EggRenderOptions   *options);
+
+void        egg_piecewise_linear_render     (EggDataPoints            *points,
+                                             cairo_t                  *cr,
+                                             gint                      width,
+                                             gint                      height,
+                                             const EggRenderOptions   *options);
+gboolean    egg_piecewise_linear_render_png (EggDataPoints           **points,
+                                             const gchar * const      *filenames,
+                                             guint                     n_files,
+                                             gint                      width,
+                                             gint                      height,
+                                             const EggRenderOptions   *options,
+                                             guint                     n_threads,
+                                             GError                  **error);
+
+void        egg_piecewise_linear_render_background
+                                            (EggDataPoints            *points,
+                                             cairo_t                  *cr,
+                                             const EggRenderTransform *transform,
+                                             const EggRenderOptions   *options);
+void        egg_piecewise_linear_render_curve
+                                            (EggDataPoints            *points,
+                                             cairo_t                  *cr,
+                                             const EggRenderTransform *transform,
+                                             const EggRenderOptions   *options,
+                                             const EggRenderPositions *positions,
+                                             gboolean                  sorted,
+                                             const guint              *selected,
+                                             guint                     n_selected,
+                                             guint                     highlight,
+                                             EggRenderCache           *cache);
+
+G_END_DECLS
+
+#endif
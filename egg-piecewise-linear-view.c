@@ -16,9 +16,12 @@
    Franklin St, Fifth Floor, Boston, MA 02110, USA */
 
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "egg-piecewise-linear-view.h"
+#include "egg-piecewise-linear-render.h"
 #include "egg-data-points.h"
+#include "egg-curve-kernels.h"
 
 G_DEFINE_TYPE (EggPiecewiseLinearView, egg_piecewise_linear_view, GTK_TYPE_DRAWING_AREA)
 
@@ -27,6 +30,19 @@ G_DEFINE_TYPE (EggPiecewiseLinearView, egg_piecewise_linear_view, GTK_TYPE_DRAWI
 #define MIN_WIDTH   128
 #define MIN_HEIGHT  128
 
+/* Space around damaged primitives covering markers and line width */
+#define DAMAGE_PADDING  (EGG_RENDER_MARKER_RADIUS + 2)
+
+/* Milliseconds between two applied drag positions, about one frame */
+#define FRAME_INTERVAL  16
+
+/* Zoom factor of one mouse wheel step and the largest magnification */
+#define ZOOM_STEP       1.25
+#define MAX_ZOOM        1e6
+
+/* Smallest gap allocated when the cache of window positions grows */
+#define MIN_SCREEN_GAP  16
+
 struct _EggPiecewiseLinearViewPrivate
 {
     gint            border_width;
@@ -35,8 +51,6 @@ struct _EggPiecewiseLinearViewPrivate
 
     gboolean        grabbed;
     guint           dragged_index;
-    GtkAdjustment  *dragged_x;
-    GtkAdjustment  *dragged_y;
 
     gboolean        restrict_x;
     gboolean        restrict_y;
@@ -47,8 +61,72 @@ struct _EggPiecewiseLinearViewPrivate
     gboolean        grid_y;
     gdouble         grid_x_increment;
     gdouble         grid_y_increment;
+    gboolean        adaptive_grid;
     gboolean        snap_to_x;
     gboolean        snap_to_y;
+    gdouble         marker_density;
+
+    /* Latest pointer position of a drag that waits for the next frame */
+    gboolean        compress_motion;
+    guint           motion_source;
+    gdouble         pending_x;
+    gdouble         pending_y;
+
+    /* Background, frame and grid rendered once, NULL if outdated */
+    cairo_surface_t *background;
+
+    /* Marker sprites for the window, NULL until the first expose */
+    EggRenderCache *render_cache;
+
+    /* Point drawn highlighted, G_MAXUINT if none */
+    guint           hovered;
+
+    /* Generation of the points that hovered, dragged_index and the selection
+     * refer to */
+    guint64         index_generation;
+
+    /* Indices of the selected points in ascending order, and the rubber
+     * band in window coordinates while it is dragged */
+    GArray         *selection;
+    gboolean        selecting;
+    gdouble         band_x1;
+    gdouble         band_y1;
+    gdouble         band_x2;
+    gdouble         band_y2;
+
+    /* Visible part of the data range. The vertical adjustment grows
+     * downwards, so its value is measured from the upper y bound. */
+    GtkAdjustment  *hadjustment;
+    GtkAdjustment  *vadjustment;
+    gdouble         zoom_x;
+    gdouble         zoom_y;
+
+    /* Mapping to window positions. The cache holds the window positions
+     * of all points as of screen_generation. Like the store it keeps a gap
+     * of screen_gap_size unused entries at screen_gap_start, see
+     * screen_slot(). */
+    EggRenderTransform transform;
+    gboolean        screen_valid;
+    guint64         screen_generation;
+    GArray         *screen_x;
+    GArray         *screen_y;
+    guint           screen_gap_start;
+    guint           screen_gap_size;
+
+    /* Number of neighbors in the cache that are out of x order. Visible
+     * spans are only searched for if this is zero. */
+    guint           screen_inversions;
+
+    /* Grid of cached window positions for hit-testing, see hit_cell(). The
+     * links are indexed by cache entry like screen_x. */
+    guint           hit_radius;
+    gboolean        hit_valid;
+    guint           hit_columns;
+    guint           hit_rows;
+    GArray         *hit_heads;
+    GArray         *hit_next;
+    GArray         *hit_prev;
+    GArray         *hit_cells;
 };
 
 enum
@@ -58,6 +136,7 @@ enum
     PROP_GRID_Y,
     PROP_GRID_X_INCREMENT,
     PROP_GRID_Y_INCREMENT,
+    PROP_ADAPTIVE_GRID,
     PROP_SNAP_TO_X,
     PROP_SNAP_TO_Y,
     PROP_FIXED_X,
@@ -65,258 +144,1663 @@ enum
     PROP_FIXED_BORDERS,
     PROP_RESTRICT_X,
     PROP_RESTRICT_Y,
+    PROP_COMPRESS_MOTION,
+    PROP_MARKER_DENSITY,
+    PROP_HIT_RADIUS,
     N_PROPERTIES
 };
 
 enum
 {
     POINT_CHANGED,
+    DRAG_SAMPLE,
+    SET_SCROLL_ADJUSTMENTS,
+    SELECTION_CHANGED,
     LAST_SIGNAL
 };
 
-static GParamSpec *egg_piecewise_linear_view_properties[N_PROPERTIES] = { NULL, };
+static GParamSpec *egg_piecewise_linear_view_properties[N_PROPERTIES] = { NULL, };
+
+static guint egg_piecewise_linear_view_signals[LAST_SIGNAL] = { 0 };
+
+static void on_value_changed (EggDataPoints *points, guint index, EggPiecewiseLinearView *view);
+static void selection_changed (EggPiecewiseLinearView *view);
+static void on_point_inserted (EggDataPoints *points, guint index, EggPiecewiseLinearView *view);
+static void on_point_removed (EggDataPoints *points, guint index, EggPiecewiseLinearView *view);
+static void on_points_changed (EggDataPoints *points, guint first, guint last, EggPiecewiseLinearView *view);
+static void invalidate_background (EggPiecewiseLinearView *view);
+static void configure_adjustments (EggPiecewiseLinearView *view, gdouble hvalue, gdouble vvalue);
+
+GtkWidget *
+egg_piecewise_linear_view_new (void)
+{
+    return GTK_WIDGET (g_object_new (EGG_TYPE_PIECEWISE_LINEAR_VIEW, NULL));
+}
+
+/* Stop a drag without applying pending motion */
+static void
+cancel_drag (EggPiecewiseLinearView *view)
+{
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+
+    if (priv->motion_source != 0) {
+        g_source_remove (priv->motion_source);
+        priv->motion_source = 0;
+    }
+
+    priv->grabbed = FALSE;
+}
+
+static void
+release_points (EggPiecewiseLinearView *view)
+{
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+
+    if (priv->points == NULL)
+        return;
+
+    g_signal_handlers_disconnect_by_func (priv->points, on_point_inserted, view);
+    g_signal_handlers_disconnect_by_func (priv->points, on_point_removed, view);
+    g_signal_handlers_disconnect_by_func (priv->points, on_value_changed, view);
+    g_signal_handlers_disconnect_by_func (priv->points, on_points_changed, view);
+    g_object_unref (priv->points);
+    priv->points = NULL;
+}
+
+void
+egg_piecewise_linear_view_set_points (EggPiecewiseLinearView *view, EggDataPoints *points)
+{
+    g_return_if_fail (EGG_PIECEWISE_LINEAR_VIEW (view));
+
+    /* Indices into the previous points mean nothing for the new ones */
+    g_object_ref (points);
+    release_points (view);
+    cancel_drag (view);
+    view->priv->points = points;
+    view->priv->screen_valid = FALSE;
+    view->priv->hit_valid = FALSE;
+    view->priv->hovered = G_MAXUINT;
+    view->priv->index_generation = egg_data_points_get_generation (points);
+    view->priv->selecting = FALSE;
+    invalidate_background (view);
+
+    if (view->priv->selection->len > 0) {
+        g_array_set_size (view->priv->selection, 0);
+        selection_changed (view);
+    }
+
+    configure_adjustments (view,
+                           gtk_adjustment_get_value (view->priv->hadjustment),
+                           gtk_adjustment_get_value (view->priv->vadjustment));
+
+    g_signal_connect (points, "point-inserted", G_CALLBACK (on_point_inserted), view);
+    g_signal_connect (points, "point-removed", G_CALLBACK (on_point_removed), view);
+    g_signal_connect (points, "value-changed", G_CALLBACK (on_value_changed), view);
+    g_signal_connect (points, "points-changed", G_CALLBACK (on_points_changed), view);
+}
+
+EggDataPoints *
+egg_piecewise_linear_view_get_points (EggPiecewiseLinearView *view)
+{
+    g_return_val_if_fail (EGG_PIECEWISE_LINEAR_VIEW (view), NULL);
+
+    return view->priv->points;
+}
+
+/**
+ * egg_piecewise_linear_view_get_selection:
+ * @n_selected: return location for the number of selected points
+ *
+ * Returns: the indices of the selected points in ascending order. The array
+ * is owned by the view and valid until the selection changes.
+ */
+const guint *
+egg_piecewise_linear_view_get_selection (EggPiecewiseLinearView *view, guint *n_selected)
+{
+    g_return_val_if_fail (EGG_PIECEWISE_LINEAR_VIEW (view), NULL);
+
+    if (n_selected != NULL)
+        *n_selected = view->priv->selection->len;
+
+    return (const guint *) view->priv->selection->data;
+}
+
+/**
+ * egg_piecewise_linear_view_unselect_all:
+ */
+void
+egg_piecewise_linear_view_unselect_all (EggPiecewiseLinearView *view)
+{
+    g_return_if_fail (EGG_PIECEWISE_LINEAR_VIEW (view));
+
+    if (view->priv->selection->len > 0) {
+        g_array_set_size (view->priv->selection, 0);
+        selection_changed (view);
+    }
+}
+
+/**
+ * egg_piecewise_linear_view_get_hadjustment:
+ *
+ * Returns: the adjustment that holds the visible x range.
+ */
+GtkAdjustment *
+egg_piecewise_linear_view_get_hadjustment (EggPiecewiseLinearView *view)
+{
+    g_return_val_if_fail (EGG_PIECEWISE_LINEAR_VIEW (view), NULL);
+
+    return view->priv->hadjustment;
+}
+
+/**
+ * egg_piecewise_linear_view_get_vadjustment:
+ *
+ * Returns: the adjustment that holds the visible y range, measured downwards
+ * from the upper y bound.
+ */
+GtkAdjustment *
+egg_piecewise_linear_view_get_vadjustment (EggPiecewiseLinearView *view)
+{
+    g_return_val_if_fail (EGG_PIECEWISE_LINEAR_VIEW (view), NULL);
+
+    return view->priv->vadjustment;
+}
+
+void
+egg_piecewise_linear_view_set_grid (EggPiecewiseLinearView *view,
+                                    gdouble                 x_increment,
+                                    gdouble                 y_increment)
+{
+    g_return_if_fail (EGG_PIECEWISE_LINEAR_VIEW (view));
+
+    g_object_set (view,
+                  "x-grid", x_increment > 0.0,
+                  "y-grid", y_increment > 0.0,
+                  "x-grid-increment", x_increment,
+                  "y-grid-increment", y_increment,
+                  NULL);
+}
+
+void
+egg_piecewise_linear_view_set_fixed (EggPiecewiseLinearView *view,
+                                     gboolean                fixed_x_axis,
+                                     gboolean                fixed_y_axis,
+                                     gboolean                fixed_borders,
+                                     gboolean                restrict_x,
+                                     gboolean                restrict_y)
+{
+    g_return_if_fail (EGG_PIECEWISE_LINEAR_VIEW (view));
+
+    g_object_set (view,
+                  "fixed-x-axis", fixed_x_axis,
+                  "fixed-y-axis", fixed_y_axis,
+                  "fixed-borders", fixed_borders,
+                  "restrict-x", restrict_x,
+                  "restrict-y", restrict_y,
+                  NULL);
+}
+
+static void
+egg_piecewise_linear_view_size_request (GtkWidget *widget, GtkRequisition *requisition)
+{
+    /* TODO: maybe add border width */
+    requisition->width = MIN_WIDTH;
+    requisition->height = MIN_HEIGHT;
+}
+
+/* Describe the current state of the view in terms of the renderer */
+static void
+get_render_options (EggPiecewiseLinearView *view, EggRenderOptions *options)
+{
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+    GtkStyle *style = gtk_widget_get_style (GTK_WIDGET (view));
+    gdouble lower_y, upper_y;
+
+    egg_render_options_init (options);
+    options->border_width = priv->border_width;
+    options->grid_x = priv->grid_x;
+    options->grid_y = priv->grid_y;
+    options->grid_x_increment = priv->grid_x_increment;
+    options->grid_y_increment = priv->grid_y_increment;
+    options->adaptive_grid = priv->adaptive_grid;
+    options->marker_density = priv->marker_density;
+    options->base_color = style->base[GTK_STATE_NORMAL];
+    options->line_color = style->dark[GTK_STATE_NORMAL];
+    options->highlight_color = style->text[GTK_STATE_NORMAL];
+    options->selected_color = style->bg[GTK_STATE_SELECTED];
+
+    egg_data_points_get_y_range (priv->points, &lower_y, &upper_y);
+    options->x_lower = gtk_adjustment_get_value (priv->hadjustment);
+    options->x_upper = options->x_lower + gtk_adjustment_get_page_size (priv->hadjustment);
+    options->y_upper = upper_y + lower_y - gtk_adjustment_get_value (priv->vadjustment);
+    options->y_lower = options->y_upper - gtk_adjustment_get_page_size (priv->vadjustment);
+}
+
+static void
+update_transform (EggPiecewiseLinearView *view)
+{
+    EggRenderOptions options;
+    GtkAllocation allocation;
+
+    gtk_widget_get_allocation (GTK_WIDGET (view), &allocation);
+    get_render_options (view, &options);
+    egg_render_transform_init (&view->priv->transform, view->priv->points,
+                               allocation.width, allocation.height, &options);
+}
+
+/*
+ * Entry of the cache that holds the window position of the point at @index.
+ * Inserting or removing a point moves the gap there first, which only moves
+ * the entries in between.
+ */
+static inline guint
+screen_slot (const EggPiecewiseLinearViewPrivate *priv, guint index)
+{
+    return index < priv->screen_gap_start ? index : index + priv->screen_gap_size;
+}
+
+static inline guint
+screen_index (const EggPiecewiseLinearViewPrivate *priv, guint slot)
+{
+    return slot < priv->screen_gap_start ? slot : slot - priv->screen_gap_size;
+}
+
+static inline guint
+screen_length (const EggPiecewiseLinearViewPrivate *priv)
+{
+    return priv->screen_x->len - priv->screen_gap_size;
+}
+
+static inline gdouble
+screen_x_at (const EggPiecewiseLinearViewPrivate *priv, guint index)
+{
+    return g_array_index (priv->screen_x, gdouble, screen_slot (priv, index));
+}
+
+static inline gdouble
+screen_y_at (const EggPiecewiseLinearViewPrivate *priv, guint index)
+{
+    return g_array_index (priv->screen_y, gdouble, screen_slot (priv, index));
+}
+
+/* First index with a window x position of at least @x, for sorted points */
+static guint
+screen_lower_bound (const EggPiecewiseLinearViewPrivate *priv, gdouble x)
+{
+    const gdouble *xs = (const gdouble *) priv->screen_x->data;
+    guint split = priv->screen_gap_start;
+    guint index;
+
+    index = egg_curve_kernel_lower_bound (xs, split, x);
+
+    if (index < split)
+        return index;
+
+    return split + egg_curve_kernel_lower_bound (xs + split + priv->screen_gap_size,
+                                                 screen_length (priv) - split, x);
+}
+
+static void
+get_screen_positions (EggPiecewiseLinearViewPrivate *priv, EggRenderPositions *positions)
+{
+    positions->xs = (const gdouble *) priv->screen_x->data;
+    positions->ys = (const gdouble *) priv->screen_y->data;
+    positions->gap_start = priv->screen_gap_start;
+    positions->gap_size = priv->screen_gap_size;
+}
+
+static void
+transform_run (EggPiecewiseLinearViewPrivate *priv, guint first, guint slot, guint n)
+{
+    gdouble *xs = &g_array_index (priv->screen_x, gdouble, slot);
+    gdouble *ys = &g_array_index (priv->screen_y, gdouble, slot);
+
+    egg_data_points_get_values (priv->points, first, n, xs, ys);
+    egg_curve_kernel_linear (xs, xs, n, 0.0, priv->transform.x_origin, priv->transform.x_scale);
+    egg_curve_kernel_linear (ys, ys, n, 0.0, priv->transform.y_origin, priv->transform.y_scale);
+}
+
+static void
+transform_points (EggPiecewiseLinearViewPrivate *priv, guint first, guint n)
+{
+    guint split = CLAMP (priv->screen_gap_start, first, first + n);
+
+    if (split > first)
+        transform_run (priv, first, first, split - first);
+
+    if (first + n > split)
+        transform_run (priv, split, split + priv->screen_gap_size, first + n - split);
+}
+
+/* Count the pairs (i - 1, i) with i in [first, last] that are not sorted */
+static guint
+count_inversions (EggPiecewiseLinearViewPrivate *priv, gint first, gint last)
+{
+    guint count = 0;
+
+    first = MAX (first, 1);
+    last  = MIN (last, (gint) screen_length (priv) - 1);
+
+    for (gint i = first; i <= last; i++)
+        count += screen_x_at (priv, i - 1) > screen_x_at (priv, i);
+
+    return count;
+}
+
+/*
+ * Hit-testing uses a uniform grid over the window with cells as large as the
+ * hit radius, so that a query only visits the 3x3 cells around the pointer.
+ * Each cell holds a doubly linked list of the cache entries in it, threaded
+ * through hit_next and hit_prev, so that a moving point is relinked in O(1).
+ * Points outside of the window are not linked.
+ */
+static guint
+hit_cell (EggPiecewiseLinearViewPrivate *priv, gdouble x, gdouble y)
+{
+    gdouble column = floor (x / priv->hit_radius);
+    gdouble row    = floor (y / priv->hit_radius);
+
+    if (column < 0.0 || row < 0.0 || column >= priv->hit_columns || row >= priv->hit_rows)
+        return G_MAXUINT;
+
+    return (guint) row * priv->hit_columns + (guint) column;
+}
+
+static void
+unlink_hit (EggPiecewiseLinearViewPrivate *priv, guint slot)
+{
+    guint *heads = (guint *) priv->hit_heads->data;
+    guint *next  = (guint *) priv->hit_next->data;
+    guint *prev  = (guint *) priv->hit_prev->data;
+    guint *cells = (guint *) priv->hit_cells->data;
+
+    if (cells[slot] == G_MAXUINT)
+        return;
+
+    if (prev[slot] != G_MAXUINT)
+        next[prev[slot]] = next[slot];
+    else
+        heads[cells[slot]] = next[slot];
+
+    if (next[slot] != G_MAXUINT)
+        prev[next[slot]] = prev[slot];
+
+    cells[slot] = G_MAXUINT;
+}
+
+static void
+link_hit (EggPiecewiseLinearViewPrivate *priv, guint slot, guint cell)
+{
+    guint *heads = (guint *) priv->hit_heads->data;
+    guint *next  = (guint *) priv->hit_next->data;
+    guint *prev  = (guint *) priv->hit_prev->data;
+    guint *cells = (guint *) priv->hit_cells->data;
+
+    cells[slot] = cell;
+    prev[slot]  = G_MAXUINT;
+    next[slot]  = G_MAXUINT;
+
+    if (cell == G_MAXUINT)
+        return;
+
+    next[slot] = heads[cell];
+
+    if (heads[cell] != G_MAXUINT)
+        prev[heads[cell]] = slot;
+
+    heads[cell] = slot;
+}
+
+/* Relink the points in [first, last] after their window positions changed */
+static void
+update_hits (EggPiecewiseLinearViewPrivate *priv, guint first, guint last)
+{
+    if (!priv->hit_valid)
+        return;
+
+    for (guint i = first; i <= last; i++) {
+        guint slot = screen_slot (priv, i);
+        guint cell = hit_cell (priv, g_array_index (priv->screen_x, gdouble, slot),
+                               g_array_index (priv->screen_y, gdouble, slot));
+
+        if (cell != g_array_index (priv->hit_cells, guint, slot)) {
+            unlink_hit (priv, slot);
+            link_hit (priv, slot, cell);
+        }
+    }
+}
+
+static inline guint
+move_link (guint link, guint from, guint to, guint n)
+{
+    return link != G_MAXUINT && link >= from && link < from + n ? link - from + to : link;
+}
+
+/* Carry the hit links of the @n cache entries moved from @from to @to along */
+static void
+move_hits (EggPiecewiseLinearViewPrivate *priv, guint from, guint to, guint n)
+{
+    guint *heads = (guint *) priv->hit_heads->data;
+    guint *next  = (guint *) priv->hit_next->data;
+    guint *prev  = (guint *) priv->hit_prev->data;
+    guint *cells = (guint *) priv->hit_cells->data;
+
+    memmove (next + to, next + from, n * sizeof (guint));
+    memmove (prev + to, prev + from, n * sizeof (guint));
+    memmove (cells + to, cells + from, n * sizeof (guint));
+
+    /* Links among the moved entries, then the ones pointing at them */
+    for (guint slot = to; slot < to + n; slot++) {
+        next[slot] = move_link (next[slot], from, to, n);
+        prev[slot] = move_link (prev[slot], from, to, n);
+    }
+
+    for (guint slot = to; slot < to + n; slot++) {
+        if (cells[slot] == G_MAXUINT)
+            continue;
+
+        if (prev[slot] != G_MAXUINT)
+            next[prev[slot]] = slot;
+        else
+            heads[cells[slot]] = slot;
+
+        if (next[slot] != G_MAXUINT)
+            prev[next[slot]] = slot;
+    }
+}
+
+static void
+move_screen_gap (EggPiecewiseLinearViewPrivate *priv, guint index)
+{
+    gdouble *xs = (gdouble *) priv->screen_x->data;
+    gdouble *ys = (gdouble *) priv->screen_y->data;
+    guint gap_start = priv->screen_gap_start;
+    guint gap_size = priv->screen_gap_size;
+    guint from, to, n;
+
+    if (index == gap_start)
+        return;
+
+    priv->screen_gap_start = index;
+
+    if (gap_size == 0)
+        return;
+
+    if (index < gap_start) {
+        from = index;
+        to   = index + gap_size;
+        n    = gap_start - index;
+    }
+    else {
+        from = gap_start + gap_size;
+        to   = gap_start;
+        n    = index - gap_start;
+    }
+
+    memmove (xs + to, xs + from, n * sizeof (gdouble));
+    memmove (ys + to, ys + from, n * sizeof (gdouble));
+
+    if (priv->hit_valid)
+        move_hits (priv, from, to, n);
+}
+
+/* Make room for one more point, growing the cache like the store does */
+static void
+ensure_screen_gap (EggPiecewiseLinearViewPrivate *priv)
+{
+    guint n_points = screen_length (priv);
+    guint n_tail = n_points - priv->screen_gap_start;
+    guint size;
+
+    if (priv->screen_gap_size > 0)
+        return;
+
+    size = n_points + MAX (n_points, MIN_SCREEN_GAP);
+    g_array_set_size (priv->screen_x, size);
+    g_array_set_size (priv->screen_y, size);
+    memmove (&g_array_index (priv->screen_x, gdouble, size - n_tail),
+             &g_array_index (priv->screen_x, gdouble, priv->screen_gap_start),
+             n_tail * sizeof (gdouble));
+    memmove (&g_array_index (priv->screen_y, gdouble, size - n_tail),
+             &g_array_index (priv->screen_y, gdouble, priv->screen_gap_start),
+             n_tail * sizeof (gdouble));
+
+    if (priv->hit_valid) {
+        g_array_set_size (priv->hit_next, size);
+        g_array_set_size (priv->hit_prev, size);
+        g_array_set_size (priv->hit_cells, size);
+        move_hits (priv, priv->screen_gap_start, size - n_tail, n_tail);
+    }
+
+    priv->screen_gap_size = size - n_points;
+}
+
+/* Open an unlinked cache entry for a point inserted at @index */
+static guint
+open_screen_slot (EggPiecewiseLinearViewPrivate *priv, guint index)
+{
+    move_screen_gap (priv, index);
+    ensure_screen_gap (priv);
+    priv->screen_gap_start++;
+    priv->screen_gap_size--;
+
+    if (priv->hit_valid)
+        g_array_index (priv->hit_cells, guint, index) = G_MAXUINT;
+
+    return index;
+}
+
+/* Drop the cache entry of a point removed from @index */
+static void
+close_screen_slot (EggPiecewiseLinearViewPrivate *priv, guint index)
+{
+    move_screen_gap (priv, index);
+
+    if (priv->hit_valid)
+        unlink_hit (priv, index + priv->screen_gap_size);
+
+    priv->screen_gap_size++;
+}
+
+static void
+build_hits (EggPiecewiseLinearView *view)
+{
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+    const gdouble *xs = (const gdouble *) priv->screen_x->data;
+    const gdouble *ys = (const gdouble *) priv->screen_y->data;
+    GtkAllocation allocation;
+    guint n_slots = priv->screen_x->len;
+
+    gtk_widget_get_allocation (GTK_WIDGET (view), &allocation);
+    priv->hit_columns = MAX (allocation.width, 1) / priv->hit_radius + 1;
+    priv->hit_rows    = MAX (allocation.height, 1) / priv->hit_radius + 1;
+
+    g_array_set_size (priv->hit_heads, priv->hit_columns * priv->hit_rows);
+    g_array_set_size (priv->hit_next, n_slots);
+    g_array_set_size (priv->hit_prev, n_slots);
+    g_array_set_size (priv->hit_cells, n_slots);
+
+    for (guint i = 0; i < priv->hit_heads->len; i++)
+        g_array_index (priv->hit_heads, guint, i) = G_MAXUINT;
+
+    for (guint i = 0; i < priv->screen_gap_size; i++)
+        g_array_index (priv->hit_cells, guint, priv->screen_gap_start + i) = G_MAXUINT;
+
+    /* Link backwards, so that lists are in index order */
+    for (guint i = screen_length (priv); i > 0; i--) {
+        guint slot = screen_slot (priv, i - 1);
+        link_hit (priv, slot, hit_cell (priv, xs[slot], ys[slot]));
+    }
+
+    priv->hit_valid = TRUE;
+}
+
+/*
+ * Bring the cached window positions up to date. Only the points that changed
+ * since the last call are transformed again, unless the number of points or
+ * the transformation itself changed.
+ */
+static void
+sync_screen (EggPiecewiseLinearView *view)
+{
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+    guint n_points;
+    guint first, last;
+
+    n_points = egg_data_points_get_num (priv->points);
+
+    if (!priv->screen_valid || screen_length (priv) != n_points) {
+        update_transform (view);
+        g_array_set_size (priv->screen_x, n_points);
+        g_array_set_size (priv->screen_y, n_points);
+        priv->screen_gap_start = n_points;
+        priv->screen_gap_size = 0;
+        transform_points (priv, 0, n_points);
+        priv->screen_inversions = count_inversions (priv, 1, n_points - 1);
+        priv->screen_valid = TRUE;
+        priv->hit_valid = FALSE;
+    }
+    else if (egg_data_points_get_changes_since (priv->points, priv->screen_generation, &first, &last, NULL)) {
+        last = MIN (last, n_points - 1);
+
+        if (first <= last) {
+            priv->screen_inversions -= count_inversions (priv, first, (gint) last + 1);
+            transform_points (priv, first, last - first + 1);
+            priv->screen_inversions += count_inversions (priv, first, (gint) last + 1);
+            update_hits (priv, first, last);
+        }
+    }
+
+    priv->screen_generation = egg_data_points_get_generation (priv->points);
+}
+
+/*
+ * Find the point closest to the window position (@x, @y) that is at most
+ * hit-radius pixels away. Returns G_MAXUINT if there is none. The cost is
+ * the number of points in the 3x3 cells around the position, which on dense
+ * curves can be thousands per cell.
+ */
+static guint
+find_hit (EggPiecewiseLinearView *view, gdouble x, gdouble y)
+{
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+    const gdouble *xs, *ys;
+    const guint *heads, *next;
+    gint column, row;
+    gdouble best;
+    guint closest = G_MAXUINT;
+
+    sync_screen (view);
+
+    if (!priv->hit_valid)
+        build_hits (view);
+
+    xs    = (const gdouble *) priv->screen_x->data;
+    ys    = (const gdouble *) priv->screen_y->data;
+    heads = (const guint *) priv->hit_heads->data;
+    next  = (const guint *) priv->hit_next->data;
+
+    column = (gint) floor (x / priv->hit_radius);
+    row    = (gint) floor (y / priv->hit_radius);
+    best   = (gdouble) priv->hit_radius * priv->hit_radius;
+
+    for (gint r = MAX (row - 1, 0); r <= MIN (row + 1, (gint) priv->hit_rows - 1); r++) {
+        for (gint c = MAX (column - 1, 0); c <= MIN (column + 1, (gint) priv->hit_columns - 1); c++) {
+            for (guint i = heads[r * priv->hit_columns + c]; i != G_MAXUINT; i = next[i]) {
+                gdouble dx = xs[i] - x;
+                gdouble dy = ys[i] - y;
+
+                if (dx * dx + dy * dy < best || (dx * dx + dy * dy == best && i < closest)) {
+                    best = dx * dx + dy * dy;
+                    closest = i;
+                }
+            }
+        }
+    }
+
+    return closest == G_MAXUINT ? G_MAXUINT : screen_index (priv, closest);
+}
+
+/*
+ * A damage box holds x1, y1, x2, y2 and is empty as long as x1 > x2.
+ */
+static void
+init_box (gdouble *box)
+{
+    box[0] = box[1] = G_MAXDOUBLE;
+    box[2] = box[3] = -G_MAXDOUBLE;
+}
+
+static void
+extend_box (gdouble *box, gdouble x, gdouble y)
+{
+    box[0] = MIN (box[0], x);
+    box[1] = MIN (box[1], y);
+    box[2] = MAX (box[2], x);
+    box[3] = MAX (box[3], y);
+}
+
+/* Add the cached window positions of the points in [first, last] */
+static void
+extend_box_screen (gdouble *box, EggPiecewiseLinearViewPrivate *priv, gint first, gint last)
+{
+    first = MAX (first, 0);
+    last  = MIN (last, (gint) screen_length (priv) - 1);
+
+    for (gint i = first; i <= last; i++)
+        extend_box (box, screen_x_at (priv, i), screen_y_at (priv, i));
+}
+
+static void
+queue_draw_box (GtkWidget *widget, const gdouble *box)
+{
+    gint x1, y1, x2, y2;
+
+    if (box[0] > box[2])
+        return;
+
+    x1 = (gint) floor (box[0]) - DAMAGE_PADDING;
+    y1 = (gint) floor (box[1]) - DAMAGE_PADDING;
+    x2 = (gint) ceil (box[2]) + DAMAGE_PADDING;
+    y2 = (gint) ceil (box[3]) + DAMAGE_PADDING;
+
+    gtk_widget_queue_draw_area (widget, x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+}
+
+/*
+ * Damage the segments adjacent to the points in [first, last], both at their
+ * cached positions and where they are now. Falls back to a full redraw if the
+ * cache does not line up with the points anymore.
+ */
+static void
+queue_draw_range (EggPiecewiseLinearView *view, guint first, guint last)
+{
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+    gdouble box[4];
+
+    if (!priv->screen_valid || screen_length (priv) != egg_data_points_get_num (priv->points)) {
+        gtk_widget_queue_draw (GTK_WIDGET (view));
+        return;
+    }
+
+    init_box (box);
+    extend_box_screen (box, priv, (gint) first - 1, (gint) last + 1);
+    sync_screen (view);
+    extend_box_screen (box, priv, (gint) first - 1, (gint) last + 1);
+    queue_draw_box (GTK_WIDGET (view), box);
+}
+
+/* Find @index in the sorted selection, or where it would be inserted */
+static guint
+find_selected (EggPiecewiseLinearViewPrivate *priv, guint index)
+{
+    const guint *selected = (const guint *) priv->selection->data;
+    guint lower = 0;
+    guint upper = priv->selection->len;
+
+    while (lower < upper) {
+        guint mid = lower + (upper - lower) / 2;
+
+        if (selected[mid] < index)
+            lower = mid + 1;
+        else
+            upper = mid;
+    }
+
+    return lower;
+}
+
+static gboolean
+is_selected (EggPiecewiseLinearViewPrivate *priv, guint index)
+{
+    guint position = find_selected (priv, index);
+
+    return position < priv->selection->len &&
+           g_array_index (priv->selection, guint, position) == index;
+}
+
+/* Adjust the selection to a point inserted at or removed from @index */
+static void
+shift_selection (EggPiecewiseLinearViewPrivate *priv, guint index, gboolean inserted)
+{
+    guint position = find_selected (priv, index);
+
+    if (!inserted && position < priv->selection->len &&
+        g_array_index (priv->selection, guint, position) == index)
+        g_array_remove_index (priv->selection, position);
+
+    for (guint i = position; i < priv->selection->len; i++) {
+        if (inserted)
+            g_array_index (priv->selection, guint, i)++;
+        else
+            g_array_index (priv->selection, guint, i)--;
+    }
+}
+
+static void
+on_value_changed (EggDataPoints *points, guint index, EggPiecewiseLinearView *view)
+{
+    view->priv->index_generation = egg_data_points_get_generation (points);
+    queue_draw_range (view, index, index);
+}
+
+static void
+on_point_inserted (EggDataPoints *points, guint index, EggPiecewiseLinearView *view)
+{
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+    gdouble box[4];
+    guint slot;
+
+    if (priv->hovered != G_MAXUINT && priv->hovered >= index)
+        priv->hovered++;
+
+    if (priv->grabbed && priv->dragged_index >= index)
+        priv->dragged_index++;
+
+    shift_selection (priv, index, TRUE);
+    priv->index_generation = egg_data_points_get_generation (points);
+
+    /* The cache can only be shifted if this insertion is the one change it
+     * has not seen yet */
+    if (!priv->screen_valid || screen_length (priv) + 1 != egg_data_points_get_num (points) ||
+        priv->screen_generation + 1 != egg_data_points_get_generation (points)) {
+        priv->screen_valid = FALSE;
+        gtk_widget_queue_draw (GTK_WIDGET (view));
+        return;
+    }
+
+    /* The segment (index - 1, index) was split in two */
+    init_box (box);
+    extend_box_screen (box, priv, (gint) index - 1, index);
+
+    /* Later points keep their window positions and hit links, only the
+     * new one is transformed */
+    priv->screen_inversions -= count_inversions (priv, index, index);
+    slot = open_screen_slot (priv, index);
+    transform_points (priv, index, 1);
+    priv->screen_inversions += count_inversions (priv, index, index + 1);
+
+    if (priv->hit_valid)
+        link_hit (priv, slot, hit_cell (priv,
+                                        g_array_index (priv->screen_x, gdouble, slot),
+                                        g_array_index (priv->screen_y, gdouble, slot)));
+
+    priv->screen_generation = egg_data_points_get_generation (points);
+
+    extend_box_screen (box, priv, (gint) index - 1, index + 1);
+    queue_draw_box (GTK_WIDGET (view), box);
+}
+
+static void
+on_point_removed (EggDataPoints *points, guint index, EggPiecewiseLinearView *view)
+{
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+    gdouble box[4];
+
+    if (priv->hovered == index)
+        priv->hovered = G_MAXUINT;
+    else if (priv->hovered != G_MAXUINT && priv->hovered > index)
+        priv->hovered--;
+
+    if (priv->grabbed && priv->dragged_index == index)
+        cancel_drag (view);
+    else if (priv->grabbed && priv->dragged_index > index)
+        priv->dragged_index--;
+
+    shift_selection (priv, index, FALSE);
+    priv->index_generation = egg_data_points_get_generation (points);
+
+    if (!priv->screen_valid || screen_length (priv) != egg_data_points_get_num (points) + 1 ||
+        priv->screen_generation + 1 != egg_data_points_get_generation (points)) {
+        priv->screen_valid = FALSE;
+        gtk_widget_queue_draw (GTK_WIDGET (view));
+        return;
+    }
+
+    /* The segments (index - 1, index) and (index, index + 1) were merged */
+    init_box (box);
+    extend_box_screen (box, priv, (gint) index - 1, index + 1);
+
+    priv->screen_inversions -= count_inversions (priv, index, index + 1);
+    close_screen_slot (priv, index);
+    priv->screen_inversions += count_inversions (priv, index, index);
+    priv->screen_generation = egg_data_points_get_generation (points);
+
+    extend_box_screen (box, priv, (gint) index - 1, index);
+    queue_draw_box (GTK_WIDGET (view), box);
+}
+
+static void
+on_points_changed (EggDataPoints *points, guint first, guint last, EggPiecewiseLinearView *view)
+{
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+    guint n_points = egg_data_points_get_num (points);
+    guint end = n_points;
+    guint changed_first, changed_last;
+    gboolean structural = FALSE;
+
+    /* Points were inserted or removed in a batch, so the indices from the
+     * first change on refer to other points now, even if their number is the
+     * same as before */
+    if (egg_data_points_get_changes_since (points, priv->index_generation,
+                                           &changed_first, &changed_last, &structural) &&
+        structural) {
+        end = MIN (end, MIN (first, changed_first));
+
+        if (priv->hovered != G_MAXUINT && priv->hovered >= end)
+            priv->hovered = G_MAXUINT;
+
+        if (priv->grabbed && priv->dragged_index >= end)
+            cancel_drag (view);
+    }
+
+    priv->index_generation = egg_data_points_get_generation (points);
+
+    if (priv->grabbed && priv->dragged_index >= n_points)
+        cancel_drag (view);
+
+    /* A drag moves the whole selection, it stops rather than carrying on
+     * with part of the points the user grabbed */
+    if (priv->selection->len > 0 &&
+        g_array_index (priv->selection, guint, priv->selection->len - 1) >= end) {
+        if (priv->grabbed)
+            cancel_drag (view);
+
+        g_array_set_size (priv->selection, find_selected (priv, end));
+        g_signal_emit (view, egg_piecewise_linear_view_signals[SELECTION_CHANGED], 0);
+    }
+
+    queue_draw_range (view, first, last);
+}
+
+static void
+invalidate_background (EggPiecewiseLinearView *view)
+{
+    if (view->priv->background != NULL) {
+        cairo_surface_destroy (view->priv->background);
+        view->priv->background = NULL;
+    }
+}
+
+/*
+ * Render the background into a surface the size of the widget. The layer only
+ * depends on the allocation, the style, the viewport and the grid settings
+ * and is reused until one of them changes.
+ */
+static cairo_surface_t *
+ensure_background (GtkWidget *widget)
+{
+    EggPiecewiseLinearViewPrivate *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (widget);
+    EggRenderOptions options;
+    GtkAllocation allocation;
+    cairo_t *cr;
+
+    if (priv->background != NULL)
+        return priv->background;
+
+    sync_screen (EGG_PIECEWISE_LINEAR_VIEW (widget));
+
+    gtk_widget_get_allocation (widget, &allocation);
+    priv->background = gdk_window_create_similar_surface (gtk_widget_get_window (widget),
+                                                          CAIRO_CONTENT_COLOR,
+                                                          allocation.width,
+                                                          allocation.height);
+    cr = cairo_create (priv->background);
+    get_render_options (EGG_PIECEWISE_LINEAR_VIEW (widget), &options);
+    egg_piecewise_linear_render_background (priv->points, cr, &priv->transform, &options);
+    cairo_destroy (cr);
+
+    return priv->background;
+}
+
+/*
+ * Set the visible window to start at @hvalue and @vvalue, with a page size
+ * that follows from the data range and the zoom factors.
+ */
+static void
+configure_adjustments (EggPiecewiseLinearView *view, gdouble hvalue, gdouble vvalue)
+{
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+    gdouble lower_x, upper_x;
+    gdouble lower_y, upper_y;
+    gdouble page_x, page_y;
+
+    if (priv->points == NULL)
+        return;
+
+    egg_data_points_get_x_range (priv->points, &lower_x, &upper_x);
+    egg_data_points_get_y_range (priv->points, &lower_y, &upper_y);
+    page_x = (upper_x - lower_x) / priv->zoom_x;
+    page_y = (upper_y - lower_y) / priv->zoom_y;
+
+    gtk_adjustment_configure (priv->hadjustment,
+                              CLAMP (hvalue, lower_x, upper_x - page_x),
+                              lower_x, upper_x,
+                              page_x / 10.0, page_x * 0.9, page_x);
+    gtk_adjustment_configure (priv->vadjustment,
+                              CLAMP (vvalue, lower_y, upper_y - page_y),
+                              lower_y, upper_y,
+                              page_y / 10.0, page_y * 0.9, page_y);
+}
+
+static void
+on_adjustment_changed (GtkAdjustment *adjustment, EggPiecewiseLinearView *view)
+{
+    view->priv->screen_valid = FALSE;
+    invalidate_background (view);
+    gtk_widget_queue_draw (GTK_WIDGET (view));
+}
+
+static void
+add_band (GdkRegion *region, gint x, gint y, gint width, gint height)
+{
+    GdkRectangle rect = { x, y, width, height };
+
+    gdk_region_union_with_rect (region, &rect);
+}
+
+/*
+ * Move the background layer by @dx, @dy and re-render only @stale, the strips
+ * that were scrolled in and the frame, which does not move with the data.
+ */
+static void
+scroll_background (GtkWidget *widget, gint dx, gint dy, GdkRegion *stale)
+{
+    EggPiecewiseLinearViewPrivate *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (widget);
+    EggRenderOptions options;
+    GtkAllocation allocation;
+    cairo_surface_t *background;
+    cairo_t *cr;
+
+    if (priv->background == NULL)
+        return;
+
+    gtk_widget_get_allocation (widget, &allocation);
+    background = gdk_window_create_similar_surface (gtk_widget_get_window (widget),
+                                                    CAIRO_CONTENT_COLOR,
+                                                    allocation.width,
+                                                    allocation.height);
+    cr = cairo_create (background);
+    cairo_set_source_surface (cr, priv->background, dx, dy);
+    cairo_paint (cr);
+
+    gdk_cairo_region (cr, stale);
+    cairo_clip (cr);
+    get_render_options (EGG_PIECEWISE_LINEAR_VIEW (widget), &options);
+    egg_piecewise_linear_render_background (priv->points, cr, &priv->transform, &options);
+    cairo_destroy (cr);
+
+    cairo_surface_destroy (priv->background);
+    priv->background = background;
+}
+
+/*
+ * Pan the view. Origins are whole pixels, so the window contents, the cached
+ * window positions and the background layer are all shifted instead of being
+ * recomputed, and only the strips that come into view are drawn.
+ */
+static void
+on_adjustment_value_changed (GtkAdjustment *adjustment, EggPiecewiseLinearView *view)
+{
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+    GtkWidget *widget = GTK_WIDGET (view);
+    GtkAllocation allocation;
+    GdkRegion *stale;
+    EggRenderTransform old;
+    gint dx, dy;
+    gint band_x, band_y;
+
+    if (!priv->screen_valid || !gtk_widget_get_realized (widget)) {
+        on_adjustment_changed (adjustment, view);
+        return;
+    }
+
+    sync_screen (view);
+
+    old = priv->transform;
+    update_transform (view);
+
+    dx = (gint) (priv->transform.x_origin - old.x_origin);
+    dy = (gint) (priv->transform.y_origin - old.y_origin);
+
+    if (dx == 0 && dy == 0)
+        return;
+
+    gtk_widget_get_allocation (widget, &allocation);
+
+    if (priv->transform.x_scale != old.x_scale || priv->transform.y_scale != old.y_scale ||
+        ABS (dx) >= allocation.width || ABS (dy) >= allocation.height) {
+        on_adjustment_changed (adjustment, view);
+        return;
+    }
+
+    egg_curve_kernel_linear ((gdouble *) priv->screen_x->data, (gdouble *) priv->screen_x->data,
+                             priv->screen_x->len, 0.0, dx, 1.0);
+    egg_curve_kernel_linear ((gdouble *) priv->screen_y->data, (gdouble *) priv->screen_y->data,
+                             priv->screen_y->len, 0.0, dy, 1.0);
+    priv->hit_valid = FALSE;
+
+    /* Bands along the edges cover the frame, the curve spilling over it and
+     * the contents scrolled in */
+    stale  = gdk_region_new ();
+    band_x = priv->border_width + DAMAGE_PADDING + 1 + ABS (dx);
+    band_y = priv->border_width + DAMAGE_PADDING + 1 + ABS (dy);
+
+    if (dx != 0) {
+        add_band (stale, 0, 0, band_x, allocation.height);
+        add_band (stale, allocation.width - band_x, 0, band_x, allocation.height);
+    }
+
+    if (dy != 0) {
+        add_band (stale, 0, 0, allocation.width, band_y);
+        add_band (stale, 0, allocation.height - band_y, allocation.width, band_y);
+    }
+
+    scroll_background (widget, dx, dy, stale);
+    gdk_window_scroll (gtk_widget_get_window (widget), dx, dy);
+    gdk_window_invalidate_region (gtk_widget_get_window (widget), stale, FALSE);
+    gdk_region_destroy (stale);
+}
+
+static void
+disconnect_adjustment (EggPiecewiseLinearView *view, GtkAdjustment *adjustment)
+{
+    if (adjustment == NULL)
+        return;
+
+    g_signal_handlers_disconnect_by_func (adjustment, on_adjustment_changed, view);
+    g_signal_handlers_disconnect_by_func (adjustment, on_adjustment_value_changed, view);
+    g_object_unref (adjustment);
+}
+
+static void
+egg_piecewise_linear_view_set_scroll_adjustments (EggPiecewiseLinearView *view,
+                                                  GtkAdjustment          *hadjustment,
+                                                  GtkAdjustment          *vadjustment)
+{
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+    gdouble hvalue, vvalue;
+
+    hvalue = priv->hadjustment != NULL ? gtk_adjustment_get_value (priv->hadjustment) : -G_MAXDOUBLE;
+    vvalue = priv->vadjustment != NULL ? gtk_adjustment_get_value (priv->vadjustment) : -G_MAXDOUBLE;
+
+    if (hadjustment == NULL)
+        hadjustment = GTK_ADJUSTMENT (gtk_adjustment_new (0.0, 0.0, 1.0, 0.1, 0.9, 1.0));
+
+    if (vadjustment == NULL)
+        vadjustment = GTK_ADJUSTMENT (gtk_adjustment_new (0.0, 0.0, 1.0, 0.1, 0.9, 1.0));
+
+    g_object_ref_sink (hadjustment);
+    g_object_ref_sink (vadjustment);
+    disconnect_adjustment (view, priv->hadjustment);
+    disconnect_adjustment (view, priv->vadjustment);
+    priv->hadjustment = hadjustment;
+    priv->vadjustment = vadjustment;
+
+    g_signal_connect (hadjustment, "changed", G_CALLBACK (on_adjustment_changed), view);
+    g_signal_connect (hadjustment, "value-changed", G_CALLBACK (on_adjustment_value_changed), view);
+    g_signal_connect (vadjustment, "changed", G_CALLBACK (on_adjustment_changed), view);
+    g_signal_connect (vadjustment, "value-changed", G_CALLBACK (on_adjustment_value_changed), view);
+
+    configure_adjustments (view, hvalue, vvalue);
+    on_adjustment_changed (hadjustment, view);
+}
+
+static void
+queue_draw_marker (GtkWidget *widget, guint index)
+{
+    EggPiecewiseLinearViewPrivate
+                    *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (widget);
+    gdouble          box[4];
+
+    sync_screen (EGG_PIECEWISE_LINEAR_VIEW (widget));
+    init_box (box);
+    extend_box_screen (box, priv, index, index);
+    queue_draw_box (widget, box);
+}
+
+static void
+set_hovered (GtkWidget *widget, guint index)
+{
+    EggPiecewiseLinearViewPrivate
+                    *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (widget);
+
+    if (priv->hovered == index)
+        return;
+
+    if (priv->hovered != G_MAXUINT && priv->hovered < egg_data_points_get_num (priv->points))
+        queue_draw_marker (widget, priv->hovered);
+
+    priv->hovered = index;
+
+    if (index != G_MAXUINT)
+        queue_draw_marker (widget, index);
+}
+
+static gboolean
+egg_piecewise_linear_view_expose (GtkWidget *widget, GdkEventExpose *event)
+{
+    EggPiecewiseLinearViewPrivate
+                    *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (widget);
+    EggRenderOptions options;
+    EggRenderPositions positions;
+    GtkAllocation    allocation;
+    cairo_t         *cr;
+
+    sync_screen (EGG_PIECEWISE_LINEAR_VIEW (widget));
+
+    cr = gdk_cairo_create (gtk_widget_get_window (widget));
+    gdk_cairo_region (cr, event->region);
+    cairo_clip (cr);
+
+    cairo_set_source_surface (cr, ensure_background (widget), 0, 0);
+    cairo_paint (cr);
+
+    /* Keep the parts of the curve that are scrolled out of view off the
+     * margin around the frame */
+    gtk_widget_get_allocation (widget, &allocation);
+    cairo_rectangle (cr,
+                     priv->border_width - DAMAGE_PADDING,
+                     priv->border_width - DAMAGE_PADDING,
+                     allocation.width - 2 * (priv->border_width - DAMAGE_PADDING),
+                     allocation.height - 2 * (priv->border_width - DAMAGE_PADDING));
+    cairo_clip (cr);
+
+    if (priv->render_cache == NULL)
+        priv->render_cache = egg_render_cache_new ();
+
+    get_render_options (EGG_PIECEWISE_LINEAR_VIEW (widget), &options);
+    get_screen_positions (priv, &positions);
+    egg_piecewise_linear_render_curve (priv->points, cr, &priv->transform, &options,
+                                       &positions,
+                                       priv->screen_inversions == 0,
+                                       (const guint *) priv->selection->data,
+                                       priv->selection->len,
+                                       priv->hovered,
+                                       priv->render_cache);
+
+    if (priv->selecting) {
+        GtkStyle *style = gtk_widget_get_style (widget);
+
+        cairo_rectangle (cr,
+                         floor (MIN (priv->band_x1, priv->band_x2)) + 0.5,
+                         floor (MIN (priv->band_y1, priv->band_y2)) + 0.5,
+                         floor (fabs (priv->band_x2 - priv->band_x1)),
+                         floor (fabs (priv->band_y2 - priv->band_y1)));
+        gdk_cairo_set_source_color (cr, &style->bg[GTK_STATE_SELECTED]);
+        cairo_set_line_width (cr, 1.0);
+        cairo_stroke_preserve (cr);
+        cairo_clip (cr);
+        cairo_paint_with_alpha (cr, 0.25);
+    }
+
+    cairo_destroy (cr);
+    return FALSE;
+}
+
+static void
+egg_piecewise_linear_view_size_allocate (GtkWidget *widget, GtkAllocation *allocation)
+{
+    GtkAllocation old_allocation;
+
+    gtk_widget_get_allocation (widget, &old_allocation);
+
+    if (old_allocation.width != allocation->width || old_allocation.height != allocation->height) {
+        invalidate_background (EGG_PIECEWISE_LINEAR_VIEW (widget));
+        EGG_PIECEWISE_LINEAR_VIEW (widget)->priv->screen_valid = FALSE;
+    }
+
+    GTK_WIDGET_CLASS (egg_piecewise_linear_view_parent_class)->size_allocate (widget, allocation);
+}
+
+static void
+egg_piecewise_linear_view_style_set (GtkWidget *widget, GtkStyle *previous_style)
+{
+    invalidate_background (EGG_PIECEWISE_LINEAR_VIEW (widget));
+
+    if (GTK_WIDGET_CLASS (egg_piecewise_linear_view_parent_class)->style_set != NULL)
+        GTK_WIDGET_CLASS (egg_piecewise_linear_view_parent_class)->style_set (widget, previous_style);
+}
+
+/*
+ * Motion hints deliver only the latest pointer position, which is what the
+ * once-per-frame drag applies. Without compression, or when "drag-sample"
+ * wants every position, all motion events are requested.
+ */
+static void
+update_motion_hints (GtkWidget *widget)
+{
+    EggPiecewiseLinearViewPrivate
+                    *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (widget);
+    GdkWindow       *window = gtk_widget_get_window (widget);
+    GdkEventMask     events;
+
+    if (window == NULL)
+        return;
 
-static guint egg_piecewise_linear_view_signals[LAST_SIGNAL] = { 0 };
+    events = gdk_window_get_events (window);
 
-static void on_point_changed (EggDataPoints *points, guint index, EggPiecewiseLinearView *view);
+    if (priv->compress_motion &&
+        !g_signal_has_handler_pending (widget, egg_piecewise_linear_view_signals[DRAG_SAMPLE], 0, FALSE))
+        events |= GDK_POINTER_MOTION_HINT_MASK;
+    else
+        events &= ~GDK_POINTER_MOTION_HINT_MASK;
 
-GtkWidget *
-egg_piecewise_linear_view_new (void)
-{
-    return GTK_WIDGET (g_object_new (EGG_TYPE_PIECEWISE_LINEAR_VIEW, NULL));
+    gdk_window_set_events (window, events);
 }
 
-void
-egg_piecewise_linear_view_set_points (EggPiecewiseLinearView *view, EggDataPoints *points)
+static void
+egg_piecewise_linear_view_realize (GtkWidget *widget)
 {
-    g_return_if_fail (EGG_PIECEWISE_LINEAR_VIEW (view));
+    GTK_WIDGET_CLASS (egg_piecewise_linear_view_parent_class)->realize (widget);
+    update_motion_hints (widget);
+}
 
-    g_object_ref (points);
-    view->priv->points = points;
+static void
+egg_piecewise_linear_view_unrealize (GtkWidget *widget)
+{
+    EggPiecewiseLinearViewPrivate
+                    *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (widget);
 
-    g_signal_connect (points, "point-inserted", G_CALLBACK (on_point_changed), view);
-    g_signal_connect (points, "point-removed", G_CALLBACK (on_point_changed), view);
-    g_signal_connect (points, "value-changed", G_CALLBACK (on_point_changed), view);
+    /* The sprites are similar to the window's surface */
+    egg_render_cache_free (priv->render_cache);
+    priv->render_cache = NULL;
+    invalidate_background (EGG_PIECEWISE_LINEAR_VIEW (widget));
+    GTK_WIDGET_CLASS (egg_piecewise_linear_view_parent_class)->unrealize (widget);
 }
 
-EggDataPoints *
-egg_piecewise_linear_view_get_points (EggPiecewiseLinearView *view)
+static void
+set_cursor_type (EggPiecewiseLinearView *view, GdkCursorType cursor_type)
 {
-    g_return_val_if_fail (EGG_PIECEWISE_LINEAR_VIEW (view), NULL);
+    if (cursor_type != view->priv->cursor_type) {
+        GdkCursor *cursor = gdk_cursor_new (cursor_type);
 
-    return view->priv->points;
+        gdk_window_set_cursor (gtk_widget_get_window (GTK_WIDGET(view)), cursor);
+        gdk_cursor_unref (cursor);
+        view->priv->cursor_type = cursor_type;
+    }
 }
 
-void
-egg_piecewise_linear_view_set_grid (EggPiecewiseLinearView *view,
-                                    gdouble                 x_increment,
-                                    gdouble                 y_increment)
+static void
+window_to_data (GtkWidget *widget, gint in_x, gint in_y, gdouble *out_x, gdouble *out_y)
 {
-    g_return_if_fail (EGG_PIECEWISE_LINEAR_VIEW (view));
+    EggPiecewiseLinearViewPrivate
+                    *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (widget);
 
-    g_object_set (view,
-                  "x-grid", x_increment > 0.0,
-                  "y-grid", y_increment > 0.0,
-                  "x-grid-increment", x_increment,
-                  "y-grid-increment", y_increment,
-                  NULL);
+    sync_screen (EGG_PIECEWISE_LINEAR_VIEW (widget));
+    *out_x = (in_x - priv->transform.x_origin) / priv->transform.x_scale;
+    *out_y = (in_y - priv->transform.y_origin) / priv->transform.y_scale;
 }
 
-void
-egg_piecewise_linear_view_set_fixed (EggPiecewiseLinearView *view,
-                                     gboolean                fixed_x_axis,
-                                     gboolean                fixed_y_axis,
-                                     gboolean                fixed_borders,
-                                     gboolean                restrict_x,
-                                     gboolean                restrict_y)
+/*
+ * Find the point under the window position (@x, @y) that may be grabbed.
+ * Returns G_MAXUINT if there is none.
+ */
+static guint
+get_grabbable_point (GtkWidget *widget, gdouble x, gdouble y)
 {
-    g_return_if_fail (EGG_PIECEWISE_LINEAR_VIEW (view));
+    EggPiecewiseLinearViewPrivate
+                    *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (widget);
+    guint            index;
 
-    g_object_set (view,
-                  "fixed-x-axis", fixed_x_axis,
-                  "fixed-y-axis", fixed_y_axis,
-                  "fixed-borders", fixed_borders,
-                  "restrict-x", restrict_x,
-                  "restrict-y", restrict_y,
-                  NULL);
+    if (priv->points == NULL)
+        return G_MAXUINT;
+
+    index = find_hit (EGG_PIECEWISE_LINEAR_VIEW (widget), x, y);
+
+    if (priv->fixed_borders && (index == 0 || index == egg_data_points_get_num (priv->points) - 1))
+        return G_MAXUINT;
+
+    return index;
 }
 
 static void
-egg_piecewise_linear_view_size_request (GtkWidget *widget, GtkRequisition *requisition)
+selection_changed (EggPiecewiseLinearView *view)
 {
-    /* TODO: maybe add border width */
-    requisition->width = MIN_WIDTH;
-    requisition->height = MIN_HEIGHT;
+    gtk_widget_queue_draw (GTK_WIDGET (view));
+    g_signal_emit (view, egg_piecewise_linear_view_signals[SELECTION_CHANGED], 0);
 }
 
 static void
-map_x_to_window (gdouble *x, gdouble xscale, gdouble width)
+toggle_selected (EggPiecewiseLinearView *view, guint index)
 {
-    *x /= xscale;
-    *x *= width;
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+    guint position = find_selected (priv, index);
+
+    if (position < priv->selection->len && g_array_index (priv->selection, guint, position) == index)
+        g_array_remove_index (priv->selection, position);
+    else
+        g_array_insert_val (priv->selection, position, index);
+
+    selection_changed (view);
 }
 
 static void
-map_y_to_window (gdouble *y, gdouble yscale, gdouble height)
+select_only (EggPiecewiseLinearView *view, guint index)
 {
-    *y /= yscale;
-    *y = height - (*y) * height;
+    g_array_set_size (view->priv->selection, 0);
+    g_array_append_val (view->priv->selection, index);
+    selection_changed (view);
 }
 
+/*
+ * Select the points within the rubber band. With @extend, they are added to
+ * the points that were selected before.
+ */
 static void
-on_point_changed (EggDataPoints *points, guint index, EggPiecewiseLinearView *view)
+select_band (EggPiecewiseLinearView *view, gboolean extend)
 {
-    gtk_widget_queue_draw (GTK_WIDGET (view));
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+    const guint *old;
+    GArray *selection;
+    gdouble x1, y1, x2, y2;
+    guint n_points, n_old;
+    guint j = 0;
+
+    sync_screen (view);
+    n_points = screen_length (priv);
+
+    x1 = MIN (priv->band_x1, priv->band_x2);
+    y1 = MIN (priv->band_y1, priv->band_y2);
+    x2 = MAX (priv->band_x1, priv->band_x2);
+    y2 = MAX (priv->band_y1, priv->band_y2);
+
+    old   = (const guint *) priv->selection->data;
+    n_old = extend ? priv->selection->len : 0;
+    selection = g_array_new (FALSE, FALSE, sizeof (guint));
+
+    /* Merge with the previous selection, both are in ascending order */
+    for (guint i = 0; i < n_points; i++) {
+        gdouble x = screen_x_at (priv, i);
+        gdouble y = screen_y_at (priv, i);
+        gboolean inside = x >= x1 && x <= x2 && y >= y1 && y <= y2;
+
+        if (priv->fixed_borders && (i == 0 || i == n_points - 1))
+            inside = FALSE;
+
+        while (j < n_old && old[j] < i)
+            j++;
+
+        if (inside || (j < n_old && old[j] == i))
+            g_array_append_val (selection, i);
+    }
+
+    g_array_free (priv->selection, TRUE);
+    priv->selection = selection;
+    selection_changed (view);
 }
 
-static gboolean
-egg_piecewise_linear_view_expose (GtkWidget *widget, GdkEventExpose *event)
+static void
+queue_draw_band (GtkWidget *widget)
 {
-    const static gdouble dashes[2] = { 0.5, 4.0 };
-
     EggPiecewiseLinearViewPrivate
                     *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (widget);
-    GtkStyle        *style = gtk_widget_get_style (widget);
-    GtkAllocation    allocation;
-    cairo_t         *cr;
-    gint             border;
-    gint             width, height;
-    gdouble          x, y;
-    gdouble          lower_x, upper_x;
-    gdouble          lower_y, upper_y;
-    gdouble          xscale, yscale;
-    guint            n_points;
-
-    cr = gdk_cairo_create (gtk_widget_get_window (widget));
-    gdk_cairo_region (cr, event->region);
-    cairo_clip (cr);
-
-    /* Draw the background */
-    gdk_cairo_set_source_color (cr, &style->base[GTK_STATE_NORMAL]);
-    cairo_paint (cr);
+    gdouble          box[4];
 
-    gtk_widget_get_allocation (widget, &allocation);
-    border = priv->border_width;
-    width  = allocation.width - 2 * border;
-    height = allocation.height - 2 * border;
+    init_box (box);
+    extend_box (box, priv->band_x1, priv->band_y1);
+    extend_box (box, priv->band_x2, priv->band_y2);
+    queue_draw_box (widget, box);
+}
 
-    gdk_cairo_set_source_color (cr, &style->dark[GTK_STATE_NORMAL]);
-    cairo_set_line_width (cr, 1.0);
-    cairo_set_line_cap (cr, CAIRO_LINE_CAP_SQUARE);
-    cairo_translate (cr, 0.5, 0.5);
-    cairo_rectangle (cr, border, border, width - 1, height - 1);
-    cairo_stroke (cr);
+/*
+ * Move the selection by (@dx, @dy) as a single update. The delta is limited
+ * so that the points stay within the data range and, with restrict-x and
+ * restrict-y, each run of selected points stays between its unselected
+ * neighbors. Points within a run keep their order as they all move alike.
+ */
+static void
+move_selection (EggPiecewiseLinearView *view, gdouble dx, gdouble dy)
+{
+    EggPiecewiseLinearViewPrivate *priv = view->priv;
+    const guint *selected = (const guint *) priv->selection->data;
+    guint n_selected = priv->selection->len;
+    guint n_points;
+    gdouble lower_x, upper_x;
+    gdouble lower_y, upper_y;
+    gdouble min_dx = -G_MAXDOUBLE, max_dx = G_MAXDOUBLE;
+    gdouble min_dy = -G_MAXDOUBLE, max_dy = G_MAXDOUBLE;
 
-    /* Scale to the data point coordinate system */
+    n_points = egg_data_points_get_num (priv->points);
     egg_data_points_get_x_range (priv->points, &lower_x, &upper_x);
     egg_data_points_get_y_range (priv->points, &lower_y, &upper_y);
 
-    xscale = upper_x - lower_x;
-    yscale = upper_y - lower_y;
-
-    /* Draw grid */
-    if (priv->grid_x) {
-        for (gdouble x = lower_x + priv->grid_x_increment; x < upper_x; x += priv->grid_x_increment) {
-            gdouble xp = x;
-            map_x_to_window (&xp, xscale, width);
-            xp += border;
-            cairo_move_to (cr, floor (xp), border);
-            cairo_line_to (cr, floor (xp), height);
+    for (guint i = 0; i < n_selected; i++) {
+        guint   index = selected[i];
+        gdouble x = egg_data_points_get_x_value (priv->points, index);
+        gdouble y = egg_data_points_get_y_value (priv->points, index);
+
+        min_dx = MAX (min_dx, lower_x - x);
+        max_dx = MIN (max_dx, upper_x - x);
+        min_dy = MAX (min_dy, lower_y - y);
+        max_dy = MIN (max_dy, upper_y - y);
+
+        /* First point of a run */
+        if (index > 0 && (i == 0 || selected[i - 1] != index - 1)) {
+            if (priv->restrict_x)
+                min_dx = MAX (min_dx, egg_data_points_get_x_value (priv->points, index - 1) - x);
+
+            if (priv->restrict_y)
+                min_dy = MAX (min_dy, egg_data_points_get_y_value (priv->points, index - 1) - y);
         }
-    }
 
-    if (priv->grid_y) {
-        for (gdouble y = lower_y + priv->grid_y_increment; y < upper_y; y += priv->grid_y_increment) {
-            gdouble yp = y;
-            map_y_to_window (&yp, yscale, height);
-            yp += border;
-            cairo_move_to (cr, border, floor (yp));
-            cairo_line_to (cr, width, floor (yp));
+        /* Last point of a run */
+        if (index < n_points - 1 && (i == n_selected - 1 || selected[i + 1] != index + 1)) {
+            if (priv->restrict_x)
+                max_dx = MIN (max_dx, egg_data_points_get_x_value (priv->points, index + 1) - x);
+
+            if (priv->restrict_y)
+                max_dy = MIN (max_dy, egg_data_points_get_y_value (priv->points, index + 1) - y);
         }
     }
 
-    cairo_set_dash (cr, dashes, 2, 0.0);
-    cairo_stroke (cr);
+    dx = min_dx <= max_dx ? CLAMP (dx, min_dx, max_dx) : 0.0;
+    dy = min_dy <= max_dy ? CLAMP (dy, min_dy, max_dy) : 0.0;
 
-    /* Draw lines */
-    n_points = egg_data_points_get_num (priv->points);
-    x = egg_data_points_get_x_value (priv->points, 0);
-    y = egg_data_points_get_y_value (priv->points, 0);
+    if (dx == 0.0 && dy == 0.0)
+        return;
+
+    /* Redrawn once by the store's "points-changed" */
+    egg_data_points_begin_update (priv->points);
 
-    cairo_set_line_width (cr, 1.5);
-    map_x_to_window (&x, xscale, width);
-    map_y_to_window (&y, yscale, height);
-    cairo_move_to (cr, x + border, y + border);
+    for (guint i = 0; i < n_selected; i++) {
+        if (dx != 0.0)
+            egg_data_points_set_x (priv->points, selected[i],
+                                   egg_data_points_get_x_value (priv->points, selected[i]) + dx);
 
-    for (guint i = 1; i < n_points; i++) {
-        x = egg_data_points_get_x_value (priv->points, i);
-        y = egg_data_points_get_y_value (priv->points, i);
-        map_x_to_window (&x, xscale, width);
-        map_y_to_window (&y, yscale, height);
-        cairo_line_to (cr, x + border, y + border);
+        if (dy != 0.0)
+            egg_data_points_set_y (priv->points, selected[i],
+                                   egg_data_points_get_y_value (priv->points, selected[i]) + dy);
     }
 
-    cairo_set_dash (cr, NULL, 0, 0.0);
-    cairo_stroke (cr);
+    egg_data_points_end_update (priv->points);
+}
 
-    /* Draw points */
-#define RADIUS 3
-    for (guint i = 0; i < n_points; i++) {
-        x = egg_data_points_get_x_value (priv->points, i);
-        y = egg_data_points_get_y_value (priv->points, i);
-        map_x_to_window (&x, xscale, width);
-        map_y_to_window (&y, yscale, height);
-        cairo_move_to (cr, x + RADIUS + border, y + border);
-        cairo_arc (cr, x + border, y + border, RADIUS, 0, 2 * G_PI);
-        cairo_fill (cr);
-    }
+/*
+ * Move the dragged point to the window position (@wx, @wy), taking the rest
+ * of the selection along.
+ */
+static void
+drag_to (GtkWidget *widget, gdouble wx, gdouble wy)
+{
+    EggPiecewiseLinearViewPrivate
+                    *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (widget);
+    gdouble          x, y;
+    gdouble          dx = 0.0, dy = 0.0;
 
-    cairo_destroy (cr);
+    window_to_data (widget, wx, wy, &x, &y);
+
+    if (!priv->fixed_x)
+        dx = x - egg_data_points_get_x_value (priv->points, priv->dragged_index);
+
+    if (!priv->fixed_y)
+        dy = y - egg_data_points_get_y_value (priv->points, priv->dragged_index);
+
+    move_selection (EGG_PIECEWISE_LINEAR_VIEW (widget), dx, dy);
+}
+
+static gboolean
+on_motion_timeout (gpointer user_data)
+{
+    EggPiecewiseLinearViewPrivate
+                    *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (user_data);
+
+    priv->motion_source = 0;
+    drag_to (GTK_WIDGET (user_data), priv->pending_x, priv->pending_y);
     return FALSE;
 }
 
+/*
+ * Apply a drag position that is still waiting for the next frame.
+ */
 static void
-set_cursor_type (EggPiecewiseLinearView *view, GdkCursorType cursor_type)
+flush_motion (GtkWidget *widget)
 {
-    if (cursor_type != view->priv->cursor_type) {
-        GdkCursor *cursor = gdk_cursor_new (cursor_type);
+    EggPiecewiseLinearViewPrivate
+                    *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (widget);
 
-        gdk_window_set_cursor (gtk_widget_get_window (GTK_WIDGET(view)), cursor);
-        gdk_cursor_unref (cursor);
-        view->priv->cursor_type = cursor_type;
+    if (priv->motion_source != 0) {
+        g_source_remove (priv->motion_source);
+        on_motion_timeout (widget);
     }
 }
 
-static void
-get_closest_point (GtkWidget *widget, gint in_x, gint in_y, gdouble *out_x, gdouble *out_y, guint *index, gdouble *distance)
+/*
+ * Split the segment nearest to the window position (@wx, @wy) with a new
+ * point on it, so the shape does not change until the point is dragged. The
+ * segment must pass within hit-radius pixels of the position. Returns the
+ * index of the new point or G_MAXUINT.
+ */
+static guint
+split_segment (GtkWidget *widget, gdouble wx, gdouble wy)
 {
-    EggPiecewiseLinearView
-                    *view = EGG_PIECEWISE_LINEAR_VIEW (widget);
     EggPiecewiseLinearViewPrivate
-                    *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (view);
-    GtkAllocation    allocation;
-    gint             border;
-    gint             width, height;
-    gdouble          lower_x, upper_x;
-    gdouble          lower_y, upper_y;
-    gdouble          x, y;
+                    *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (widget);
+    gdouble          radius = priv->hit_radius;
+    gdouble          best = radius * radius;
+    gdouble          best_t = 0.0;
+    gdouble          x0, y0, x1, y1;
+    guint            best_segment = G_MAXUINT;
+    guint            n_points;
+    guint            first;
 
-    gtk_widget_get_allocation (widget, &allocation);
-    border = priv->border_width;
-    width  = allocation.width - 2 * border;
-    height = allocation.height - 2 * border;
-    x = (gdouble) (in_x - border) / (gdouble) width;
-    y = (gdouble) (height - in_y - border) / (gdouble) height;
+    if (priv->points == NULL)
+        return G_MAXUINT;
 
-    egg_data_points_get_x_range (priv->points, &lower_x, &upper_x);
-    egg_data_points_get_y_range (priv->points, &lower_y, &upper_y);
+    sync_screen (EGG_PIECEWISE_LINEAR_VIEW (widget));
+
+    /* Segments are only well defined for points sorted by x */
+    if (priv->screen_inversions != 0)
+        return G_MAXUINT;
+
+    n_points = screen_length (priv);
 
-    x *= upper_x;
-    y *= upper_y;
+    /* Only segments that reach into [wx - radius, wx + radius] can be close
+     * enough, the first of them may start left of it */
+    first = screen_lower_bound (priv, wx - radius);
+    first = first > 0 ? first - 1 : 0;
 
-    *index = egg_data_get_closest_point (priv->points, x, y, distance);
-    *out_x = x;
-    *out_y = y;
+    for (guint i = first; i + 1 < n_points && screen_x_at (priv, i) <= wx + radius; i++) {
+        gdouble x = screen_x_at (priv, i);
+        gdouble y = screen_y_at (priv, i);
+        gdouble dx = screen_x_at (priv, i + 1) - x;
+        gdouble dy = screen_y_at (priv, i + 1) - y;
+        gdouble length = dx * dx + dy * dy;
+        gdouble t, ex, ey;
+
+        if (length == 0.0)
+            continue;
+
+        /* Perpendicular distance, away from the end points which are grabbed
+         * instead */
+        t = ((wx - x) * dx + (wy - y) * dy) / length;
+
+        if (t <= 0.0 || t >= 1.0)
+            continue;
+
+        ex = x + t * dx - wx;
+        ey = y + t * dy - wy;
+
+        if (ex * ex + ey * ey <= best) {
+            best = ex * ex + ey * ey;
+            best_t = t;
+            best_segment = i;
+        }
+    }
+
+    if (best_segment == G_MAXUINT)
+        return G_MAXUINT;
+
+    x0 = egg_data_points_get_x_value (priv->points, best_segment);
+    y0 = egg_data_points_get_y_value (priv->points, best_segment);
+    x1 = egg_data_points_get_x_value (priv->points, best_segment + 1);
+    y1 = egg_data_points_get_y_value (priv->points, best_segment + 1);
+
+    egg_data_points_insert_point (priv->points, best_segment + 1,
+                                  x0 + best_t * (x1 - x0),
+                                  y0 + best_t * (y1 - y0));
+
+    return best_segment + 1;
 }
 
 static gboolean
@@ -326,27 +1810,67 @@ egg_piecewise_linear_button_press (GtkWidget *widget, GdkEventButton *event)
                     *view = EGG_PIECEWISE_LINEAR_VIEW (widget);
     EggPiecewiseLinearViewPrivate
                     *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (view);
-    gdouble          x, y;
-    gdouble          distance;
-    guint            closest;
-    guint            n_points;
+    gboolean         extend;
+    guint            index;
 
     if (event->button != 1)
         return TRUE;
 
-    get_closest_point (widget, event->x, event->y, &x, &y, &closest, &distance);
-    n_points = egg_data_points_get_num (priv->points);
+    /* "drag-sample" handlers may have come or gone since the last drag */
+    update_motion_hints (widget);
+
+    extend = (event->state & (GDK_SHIFT_MASK | GDK_CONTROL_MASK)) != 0;
+    index = get_grabbable_point (widget, event->x, event->y);
+
+    if (event->type == GDK_2BUTTON_PRESS) {
+        /* The first click of a double-click on the curve started a band */
+        if (index != G_MAXUINT || extend)
+            return TRUE;
 
-    if (!priv->fixed_borders || (closest > 0 && (closest < n_points - 1))) {
-        if (distance < 0.1) {
-            priv->grabbed   = TRUE;
-            priv->dragged_x = egg_data_points_get_x (priv->points, closest);
-            priv->dragged_y = egg_data_points_get_y (priv->points, closest);
-            priv->dragged_index = closest;
+        index = split_segment (widget, event->x, event->y);
 
-            set_cursor_type (view, GDK_FLEUR);
+        if (index == G_MAXUINT)
+            return TRUE;
+
+        if (priv->selecting) {
+            priv->selecting = FALSE;
+            queue_draw_band (widget);
+        }
+
+        /* Pick up the new point right away */
+        select_only (view, index);
+        priv->grabbed   = TRUE;
+        priv->dragged_index = index;
+
+        set_cursor_type (view, GDK_FLEUR);
+    }
+    else if (event->type != GDK_BUTTON_PRESS) {
+        return TRUE;
+    }
+    else if (index == G_MAXUINT) {
+        /* Start a rubber band on the empty background */
+        priv->selecting = TRUE;
+        priv->band_x1 = priv->band_x2 = event->x;
+        priv->band_y1 = priv->band_y2 = event->y;
+
+        if (!extend && priv->selection->len > 0) {
+            g_array_set_size (priv->selection, 0);
+            selection_changed (view);
         }
     }
+    else if (extend) {
+        toggle_selected (view, index);
+    }
+    else {
+        /* Dragging a selected point moves the whole selection */
+        if (!is_selected (priv, index))
+            select_only (view, index);
+
+        priv->grabbed   = TRUE;
+        priv->dragged_index = index;
+
+        set_cursor_type (view, GDK_FLEUR);
+    }
 
     return TRUE;
 }
@@ -368,27 +1892,36 @@ egg_piecewise_linear_button_release (GtkWidget *widget, GdkEventButton *event)
     if (event->button != 1)
         return TRUE;
 
+    if (priv->selecting) {
+        priv->selecting = FALSE;
+        queue_draw_band (widget);
+        select_band (view, (event->state & (GDK_SHIFT_MASK | GDK_CONTROL_MASK)) != 0);
+    }
+
     if (priv->grabbed) {
-        if (priv->grid_x && priv->snap_to_x) {
-            GtkAdjustment *adj;
-            gdouble        x;
+        gdouble dx = 0.0, dy = 0.0;
+
+        flush_motion (widget);
+
+        /* Snap the dragged point, the rest of the selection keeps its offset */
+        if (priv->grid_x && priv->snap_to_x && priv->grid_x_increment > 0.0) {
+            gdouble x;
 
-            adj = egg_data_points_get_x (priv->points, priv->dragged_index);
-            x = gtk_adjustment_get_value (adj);
-            gtk_adjustment_set_value (adj, snap_value (x, priv->grid_x_increment));
+            x = egg_data_points_get_x_value (priv->points, priv->dragged_index);
+            dx = snap_value (x, priv->grid_x_increment) - x;
         }
 
-        if (priv->grid_y && priv->snap_to_y) {
-            GtkAdjustment *adj;
-            gdouble        y;
+        if (priv->grid_y && priv->snap_to_y && priv->grid_y_increment > 0.0) {
+            gdouble y;
 
-            adj = egg_data_points_get_y (priv->points, priv->dragged_index);
-            y = gtk_adjustment_get_value (adj);
-            gtk_adjustment_set_value (adj, snap_value (y, priv->grid_y_increment));
+            y = egg_data_points_get_y_value (priv->points, priv->dragged_index);
+            dy = snap_value (y, priv->grid_y_increment) - y;
         }
 
-        gtk_widget_queue_draw (widget);
+        move_selection (view, dx, dy);
 
+        /* The rest of the selection is reported by the store's
+         * "points-changed" */
         g_signal_emit (view,
                        egg_piecewise_linear_view_signals[POINT_CHANGED],
                        0, priv->dragged_index);
@@ -406,66 +1939,108 @@ egg_piecewise_linear_motion_notify (GtkWidget *widget, GdkEventMotion *event)
                     *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (widget);
     GdkCursorType    cursor_type = GDK_TCROSS;
     gdouble          x, y;
-    guint            n_points;
-    gdouble          distance;
-    guint            closest;
-    gboolean         set_x, set_y;
+    guint            index;
+
+    if (priv->selecting) {
+        /* Damage the band before and after the change */
+        queue_draw_band (widget);
+        priv->band_x2 = event->x;
+        priv->band_y2 = event->y;
+        queue_draw_band (widget);
+    }
+    else if (!priv->grabbed) {
+        index = get_grabbable_point (widget, event->x, event->y);
 
-    get_closest_point (widget, event->x, event->y, &x, &y, &closest, &distance);
-    n_points = egg_data_points_get_num (priv->points);
+        if (index != G_MAXUINT)
+            cursor_type = GDK_FLEUR;
 
-    if (!priv->grabbed) {
-        if (!priv->fixed_borders || (closest > 0 && closest < n_points - 1)) {
-            if (distance < 0.1)
-                cursor_type = GDK_FLEUR;
-        }
+        set_hovered (widget, index);
     }
     else {
-        set_x = !priv->fixed_x;
-        set_y = !priv->fixed_y;
-
-        if (priv->restrict_x) {
-            if (priv->dragged_index > 0) {
-                gdouble lower_x;
-                lower_x = egg_data_points_get_x_value (priv->points, priv->dragged_index - 1);
-                set_x = set_x && (x >= lower_x);
-            }
-
-            if (priv->dragged_index < n_points - 1) {
-                gdouble upper_x;
-                upper_x = egg_data_points_get_x_value (priv->points, priv->dragged_index + 1);
-                set_x = set_x && (x <= upper_x);
-            }
-        }
+        window_to_data (widget, event->x, event->y, &x, &y);
+        g_signal_emit (widget, egg_piecewise_linear_view_signals[DRAG_SAMPLE],
+                       0, priv->dragged_index, x, y);
 
-        if (priv->restrict_y) {
-            if (priv->dragged_index > 0) {
-                gdouble lower_y;
-                lower_y = egg_data_points_get_y_value (priv->points, priv->dragged_index - 1);
-                set_y = set_y && (y >= lower_y);
-            }
+        if (priv->compress_motion) {
+            /* Only the latest position is applied once per frame */
+            priv->pending_x = event->x;
+            priv->pending_y = event->y;
 
-            if (priv->dragged_index < n_points - 1) {
-                gdouble upper_y;
-                upper_y = egg_data_points_get_y_value (priv->points, priv->dragged_index + 1);
-                set_y = set_y && (y <= upper_y);
-            }
+            if (priv->motion_source == 0)
+                priv->motion_source = gdk_threads_add_timeout (FRAME_INTERVAL, on_motion_timeout, widget);
         }
-
-        if (set_x)
-            gtk_adjustment_set_value (priv->dragged_x, x);
-
-        if (set_y)
-            gtk_adjustment_set_value (priv->dragged_y, y);
+        else
+            drag_to (widget, event->x, event->y);
 
         cursor_type = GDK_FLEUR;
-        gtk_widget_queue_draw (widget);
     }
 
+    /* Ask for the next event when motion hints are in use, see
+     * update_motion_hints() */
+    gdk_event_request_motions (event);
+
     set_cursor_type (EGG_PIECEWISE_LINEAR_VIEW (widget), cursor_type);
     return TRUE;
 }
 
+static gboolean
+egg_piecewise_linear_leave_notify (GtkWidget *widget, GdkEventCrossing *event)
+{
+    if (!EGG_PIECEWISE_LINEAR_VIEW (widget)->priv->grabbed)
+        set_hovered (widget, G_MAXUINT);
+
+    return TRUE;
+}
+
+/*
+ * Zoom in or out by one step, keeping the data point under the pointer at the
+ * same window position.
+ */
+static gboolean
+egg_piecewise_linear_scroll (GtkWidget *widget, GdkEventScroll *event)
+{
+    EggPiecewiseLinearViewPrivate *priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (widget);
+    GtkAllocation allocation;
+    gdouble factor;
+    gdouble x, y;
+    gdouble lower_x, upper_x;
+    gdouble lower_y, upper_y;
+    gdouble page_x, page_y;
+    gdouble fx, fy;
+    gint border;
+
+    if (priv->points == NULL || priv->grabbed)
+        return FALSE;
+
+    if (event->direction == GDK_SCROLL_UP)
+        factor = ZOOM_STEP;
+    else if (event->direction == GDK_SCROLL_DOWN)
+        factor = 1.0 / ZOOM_STEP;
+    else
+        return FALSE;
+
+    sync_screen (EGG_PIECEWISE_LINEAR_VIEW (widget));
+    window_to_data (widget, (gint) event->x, (gint) event->y, &x, &y);
+
+    gtk_widget_get_allocation (widget, &allocation);
+    border = priv->border_width;
+    fx = (event->x - border) / MAX (allocation.width - 2 * border, 1);
+    fy = (event->y - border) / MAX (allocation.height - 2 * border, 1);
+
+    priv->zoom_x = CLAMP (priv->zoom_x * factor, 1.0, MAX_ZOOM);
+    priv->zoom_y = CLAMP (priv->zoom_y * factor, 1.0, MAX_ZOOM);
+
+    egg_data_points_get_x_range (priv->points, &lower_x, &upper_x);
+    egg_data_points_get_y_range (priv->points, &lower_y, &upper_y);
+    page_x = (upper_x - lower_x) / priv->zoom_x;
+    page_y = (upper_y - lower_y) / priv->zoom_y;
+
+    configure_adjustments (EGG_PIECEWISE_LINEAR_VIEW (widget),
+                           x - fx * page_x,
+                           upper_y + lower_y - (y + fy * page_y));
+    return TRUE;
+}
+
 static void
 egg_piecewise_linear_view_set_property (GObject        *object,
                                         guint           property_id,
@@ -480,9 +2055,11 @@ egg_piecewise_linear_view_set_property (GObject        *object,
     switch (property_id) {
         case PROP_GRID_X:
             priv->grid_x = g_value_get_boolean (value);
+            invalidate_background (EGG_PIECEWISE_LINEAR_VIEW (object));
             break;
         case PROP_GRID_Y:
             priv->grid_y = g_value_get_boolean (value);
+            invalidate_background (EGG_PIECEWISE_LINEAR_VIEW (object));
             break;
         case PROP_SNAP_TO_X:
             priv->snap_to_x = g_value_get_boolean (value);
@@ -492,9 +2069,15 @@ egg_piecewise_linear_view_set_property (GObject        *object,
             break;
         case PROP_GRID_X_INCREMENT:
             priv->grid_x_increment = g_value_get_double (value);
+            invalidate_background (EGG_PIECEWISE_LINEAR_VIEW (object));
             break;
         case PROP_GRID_Y_INCREMENT:
             priv->grid_y_increment = g_value_get_double (value);
+            invalidate_background (EGG_PIECEWISE_LINEAR_VIEW (object));
+            break;
+        case PROP_ADAPTIVE_GRID:
+            priv->adaptive_grid = g_value_get_boolean (value);
+            invalidate_background (EGG_PIECEWISE_LINEAR_VIEW (object));
             break;
         case PROP_FIXED_X:
             priv->fixed_x = g_value_get_boolean (value);
@@ -511,6 +2094,21 @@ egg_piecewise_linear_view_set_property (GObject        *object,
         case PROP_RESTRICT_Y:
             priv->restrict_y = g_value_get_boolean (value);
             break;
+        case PROP_COMPRESS_MOTION:
+            priv->compress_motion = g_value_get_boolean (value);
+
+            if (!priv->compress_motion)
+                flush_motion (GTK_WIDGET (object));
+
+            update_motion_hints (GTK_WIDGET (object));
+            break;
+        case PROP_MARKER_DENSITY:
+            priv->marker_density = g_value_get_double (value);
+            break;
+        case PROP_HIT_RADIUS:
+            priv->hit_radius = g_value_get_uint (value);
+            priv->hit_valid = FALSE;
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             return;
@@ -549,6 +2147,9 @@ egg_piecewise_linear_view_get_property (GObject    *object,
         case PROP_GRID_Y_INCREMENT:
             g_value_set_double (value, priv->grid_y_increment);
             break;
+        case PROP_ADAPTIVE_GRID:
+            g_value_set_boolean (value, priv->adaptive_grid);
+            break;
         case PROP_FIXED_X:
             g_value_set_boolean (value, priv->fixed_x);
             break;
@@ -564,6 +2165,15 @@ egg_piecewise_linear_view_get_property (GObject    *object,
         case PROP_RESTRICT_Y:
             g_value_set_boolean (value, priv->restrict_y);
             break;
+        case PROP_COMPRESS_MOTION:
+            g_value_set_boolean (value, priv->compress_motion);
+            break;
+        case PROP_MARKER_DENSITY:
+            g_value_set_double (value, priv->marker_density);
+            break;
+        case PROP_HIT_RADIUS:
+            g_value_set_uint (value, priv->hit_radius);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             return;
@@ -576,11 +2186,38 @@ egg_piecewise_linear_view_dispose (GObject *object)
     EggPiecewiseLinearViewPrivate *priv;
 
     priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (object);
-    g_object_unref (priv->points);
+
+    cancel_drag (EGG_PIECEWISE_LINEAR_VIEW (object));
+    release_points (EGG_PIECEWISE_LINEAR_VIEW (object));
+
+    disconnect_adjustment (EGG_PIECEWISE_LINEAR_VIEW (object), priv->hadjustment);
+    disconnect_adjustment (EGG_PIECEWISE_LINEAR_VIEW (object), priv->vadjustment);
+    priv->hadjustment = NULL;
+    priv->vadjustment = NULL;
+
+    invalidate_background (EGG_PIECEWISE_LINEAR_VIEW (object));
 
     G_OBJECT_CLASS (egg_piecewise_linear_view_parent_class)->dispose (object);
 }
 
+static void
+egg_piecewise_linear_view_finalize (GObject *object)
+{
+    EggPiecewiseLinearViewPrivate *priv;
+
+    priv = EGG_PIECEWISE_LINEAR_VIEW_GET_PRIVATE (object);
+    g_array_free (priv->screen_x, TRUE);
+    g_array_free (priv->screen_y, TRUE);
+    g_array_free (priv->hit_heads, TRUE);
+    g_array_free (priv->hit_next, TRUE);
+    g_array_free (priv->hit_prev, TRUE);
+    g_array_free (priv->hit_cells, TRUE);
+    g_array_free (priv->selection, TRUE);
+    egg_render_cache_free (priv->render_cache);
+
+    G_OBJECT_CLASS (egg_piecewise_linear_view_parent_class)->finalize (object);
+}
+
 static void
 egg_piecewise_linear_view_class_init (EggPiecewiseLinearViewClass *klass)
 {
@@ -590,12 +2227,21 @@ egg_piecewise_linear_view_class_init (EggPiecewiseLinearViewClass *klass)
     gobject_class->set_property = egg_piecewise_linear_view_set_property;
     gobject_class->get_property = egg_piecewise_linear_view_get_property;
     gobject_class->dispose = egg_piecewise_linear_view_dispose;
+    gobject_class->finalize = egg_piecewise_linear_view_finalize;
 
     widget_class->size_request = egg_piecewise_linear_view_size_request;
     widget_class->expose_event = egg_piecewise_linear_view_expose;
+    widget_class->size_allocate = egg_piecewise_linear_view_size_allocate;
+    widget_class->style_set = egg_piecewise_linear_view_style_set;
+    widget_class->realize = egg_piecewise_linear_view_realize;
+    widget_class->unrealize = egg_piecewise_linear_view_unrealize;
     widget_class->button_press_event = egg_piecewise_linear_button_press;
     widget_class->button_release_event = egg_piecewise_linear_button_release;
     widget_class->motion_notify_event = egg_piecewise_linear_motion_notify;
+    widget_class->leave_notify_event = egg_piecewise_linear_leave_notify;
+    widget_class->scroll_event = egg_piecewise_linear_scroll;
+
+    klass->set_scroll_adjustments = egg_piecewise_linear_view_set_scroll_adjustments;
 
     egg_piecewise_linear_view_properties[PROP_GRID_X] =
         g_param_spec_boolean ("x-grid",
@@ -639,6 +2285,13 @@ egg_piecewise_linear_view_class_init (EggPiecewiseLinearViewClass *klass)
                              0.0, DBL_MAX, 1.0,
                              G_PARAM_READWRITE);
 
+    egg_piecewise_linear_view_properties[PROP_ADAPTIVE_GRID] =
+        g_param_spec_boolean ("adaptive-grid",
+                              "TRUE if grid lines are thinned out to keep them apart",
+                              "TRUE if grid lines are thinned out to keep them apart",
+                              TRUE,
+                              G_PARAM_READWRITE);
+
     egg_piecewise_linear_view_properties[PROP_FIXED_X] =
         g_param_spec_boolean ("fixed-x-axis",
                               "TRUE if x values cannot be changed",
@@ -674,6 +2327,27 @@ egg_piecewise_linear_view_class_init (EggPiecewiseLinearViewClass *klass)
                               FALSE,
                               G_PARAM_READWRITE);
 
+    egg_piecewise_linear_view_properties[PROP_COMPRESS_MOTION] =
+        g_param_spec_boolean ("compress-motion",
+                              "TRUE if a drag is applied at most once per frame",
+                              "TRUE if a drag is applied at most once per frame",
+                              TRUE,
+                              G_PARAM_READWRITE);
+
+    egg_piecewise_linear_view_properties[PROP_MARKER_DENSITY] =
+        g_param_spec_double ("marker-density",
+                             "Number of visible points per pixel column above which markers are hidden",
+                             "Number of visible points per pixel column above which markers are hidden",
+                             0.0, DBL_MAX, 0.25,
+                             G_PARAM_READWRITE);
+
+    egg_piecewise_linear_view_properties[PROP_HIT_RADIUS] =
+        g_param_spec_uint ("hit-radius",
+                           "Distance in pixels within which a point can be grabbed",
+                           "Distance in pixels within which a point can be grabbed",
+                           1, G_MAXINT, 8,
+                           G_PARAM_READWRITE);
+
     g_object_class_install_properties (gobject_class,
                                        N_PROPERTIES,
                                        egg_piecewise_linear_view_properties);
@@ -688,6 +2362,41 @@ egg_piecewise_linear_view_class_init (EggPiecewiseLinearViewClass *klass)
                       G_TYPE_NONE,
                       1, G_TYPE_UINT);
 
+    /* Emitted for every pointer position during a drag, even those that are
+     * skipped by motion compression. A connected handler turns motion hints
+     * off from the next button press. Coordinates are in data space. */
+    egg_piecewise_linear_view_signals[DRAG_SAMPLE] =
+        g_signal_new ("drag-sample",
+                      G_TYPE_FROM_CLASS (klass),
+                      G_SIGNAL_RUN_LAST,
+                      0,
+                      NULL, NULL,
+                      NULL,
+                      G_TYPE_NONE,
+                      3, G_TYPE_UINT, G_TYPE_DOUBLE, G_TYPE_DOUBLE);
+
+    egg_piecewise_linear_view_signals[SET_SCROLL_ADJUSTMENTS] =
+        g_signal_new ("set-scroll-adjustments",
+                      G_TYPE_FROM_CLASS (klass),
+                      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+                      G_STRUCT_OFFSET (EggPiecewiseLinearViewClass, set_scroll_adjustments),
+                      NULL, NULL,
+                      NULL,
+                      G_TYPE_NONE,
+                      2, GTK_TYPE_ADJUSTMENT, GTK_TYPE_ADJUSTMENT);
+
+    egg_piecewise_linear_view_signals[SELECTION_CHANGED] =
+        g_signal_new ("selection-changed",
+                      G_TYPE_FROM_CLASS (klass),
+                      G_SIGNAL_RUN_LAST,
+                      0,
+                      NULL, NULL,
+                      NULL,
+                      G_TYPE_NONE,
+                      0);
+
+    widget_class->set_scroll_adjustments_signal = egg_piecewise_linear_view_signals[SET_SCROLL_ADJUSTMENTS];
+
     g_type_class_add_private (klass, sizeof (EggPiecewiseLinearViewPrivate));
 }
 
@@ -711,10 +2420,37 @@ egg_piecewise_linear_view_init (EggPiecewiseLinearView *view)
     priv->fixed_borders = FALSE;
     priv->grid_x_increment = 1.0;
     priv->grid_y_increment = 1.0;
+    priv->adaptive_grid = TRUE;
+    priv->background = NULL;
+    priv->render_cache = NULL;
+    priv->screen_valid = FALSE;
+    priv->screen_inversions = 0;
+    priv->screen_x   = g_array_new (FALSE, FALSE, sizeof (gdouble));
+    priv->screen_y   = g_array_new (FALSE, FALSE, sizeof (gdouble));
+    priv->hit_radius = 8;
+    priv->hit_valid  = FALSE;
+    priv->hit_heads  = g_array_new (FALSE, FALSE, sizeof (guint));
+    priv->hit_next   = g_array_new (FALSE, FALSE, sizeof (guint));
+    priv->hit_prev   = g_array_new (FALSE, FALSE, sizeof (guint));
+    priv->hit_cells  = g_array_new (FALSE, FALSE, sizeof (guint));
+    priv->compress_motion = TRUE;
+    priv->marker_density = 0.25;
+    priv->hovered    = G_MAXUINT;
+    priv->selection  = g_array_new (FALSE, FALSE, sizeof (guint));
+    priv->selecting  = FALSE;
+    priv->hadjustment = NULL;
+    priv->vadjustment = NULL;
+    priv->zoom_x     = 1.0;
+    priv->zoom_y     = 1.0;
+    priv->motion_source = 0;
 
     gtk_widget_add_events (GTK_WIDGET (view),
                            GDK_BUTTON_PRESS_MASK   |
                            GDK_BUTTON_RELEASE_MASK |
                            GDK_BUTTON1_MOTION_MASK |
-                           GDK_POINTER_MOTION_MASK);
+                           GDK_POINTER_MOTION_MASK |
+                           GDK_LEAVE_NOTIFY_MASK   |
+                           GDK_SCROLL_MASK);
+
+    egg_piecewise_linear_view_set_scroll_adjustments (view, NULL, NULL);
 }
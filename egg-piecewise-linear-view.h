@@ -47,7 +47,10 @@ struct _EggPiecewiseLinearViewClass
     GtkDrawingAreaClass     parent_class;
 
     /* signals */
-    void (* point_changed)  (EggPiecewiseLinearView *view, guint index, gint value);
+    void (* point_changed)          (EggPiecewiseLinearView *view, guint index, gint value);
+    void (* set_scroll_adjustments) (EggPiecewiseLinearView *view,
+                                     GtkAdjustment          *hadjustment,
+                                     GtkAdjustment          *vadjustment);
 };
 
 GType           egg_piecewise_linear_view_get_type      (void);
@@ -55,6 +58,13 @@ GtkWidget     * egg_piecewise_linear_view_new           (void);
 void            egg_piecewise_linear_view_set_points    (EggPiecewiseLinearView *view,
                                                          EggDataPoints          *points);
 EggDataPoints * egg_piecewise_linear_view_get_points    (EggPiecewiseLinearView *view);
+GtkAdjustment * egg_piecewise_linear_view_get_hadjustment
+                                                        (EggPiecewiseLinearView *view);
+GtkAdjustment * egg_piecewise_linear_view_get_vadjustment
+                                                        (EggPiecewiseLinearView *view);
+const guint   * egg_piecewise_linear_view_get_selection (EggPiecewiseLinearView *view,
+                                                         guint                  *n_selected);
+void            egg_piecewise_linear_view_unselect_all  (EggPiecewiseLinearView *view);
 void            egg_piecewise_linear_view_set_fixed     (EggPiecewiseLinearView *view,
                                                          gboolean                fixed_x_axis,
                                                          gboolean                fixed_y_axis,
@@ -0,0 +1,273 @@
+/* Copyright (C) 2011, 2012 Matthias Vogelgesang <matthias.vogelgesang@kit.edu>
+   (Karlsruhe Institute of Technology)
+
+   This library is free software; you can redistribute it and/or modify it
+   under the terms of the GNU Lesser General Public License as published by the
+   Free Software Foundation; either version 2.1 of the License, or (at your
+   option) any later version.
+
+   This library is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+   details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with this library; if not, write to the Free Software Foundation, Inc., 51
+   Franklin St, Fifth Floor, Boston, MA 02110, USA */
+
+/*
+ * Times the spatial queries of EggDataPoints at 10^6 points against a brute
+ * force scan, which also checks the results. Queries are spread uniformly
+ * over the data range like pointer positions over the view. The number of
+ * points can be passed as the only argument.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <gtk/gtk.h>
+#include "egg-data-points.h"
+
+#define N_QUERIES       1000000
+#define N_CHECKED       200
+#define N_EDITS         1000
+#define K_NEAREST       8
+#define RADIUS          0.002
+
+static gdouble *xs, *ys;
+static guint    n_points;
+
+static gdouble
+random_unit (guint32 *seed)
+{
+    *seed = *seed * 1664525 + 1013904223;
+    return (*seed >> 8) / 16777216.0;
+}
+
+/* Squared normalized distance, the data range is the unit square */
+static inline gdouble
+distance2 (guint i, gdouble x, gdouble y)
+{
+    gdouble dx = xs[i] - x;
+    gdouble dy = ys[i] - y;
+
+    return dx * dx + dy * dy;
+}
+
+static gdouble
+brute_nearest (gdouble x, gdouble y)
+{
+    gdouble best = G_MAXDOUBLE;
+
+    for (guint i = 0; i < n_points; i++)
+        best = MIN (best, distance2 (i, x, y));
+
+    return sqrt (best);
+}
+
+/* Distance of the k-th closest point */
+static gdouble
+brute_kth (gdouble x, gdouble y, guint k)
+{
+    gdouble best[K_NEAREST];
+    guint   found = 0;
+
+    for (guint i = 0; i < n_points; i++) {
+        gdouble d = distance2 (i, x, y);
+        guint   pos;
+
+        if (found == k && d >= best[k - 1])
+            continue;
+
+        pos = found < k ? found++ : k - 1;
+
+        while (pos > 0 && best[pos - 1] > d) {
+            best[pos] = best[pos - 1];
+            pos--;
+        }
+
+        best[pos] = d;
+    }
+
+    return sqrt (best[k - 1]);
+}
+
+static guint
+brute_within (gdouble x, gdouble y, gdouble radius)
+{
+    guint count = 0;
+
+    for (guint i = 0; i < n_points; i++)
+        count += distance2 (i, x, y) <= radius * radius;
+
+    return count;
+}
+
+static gdouble
+elapsed_us (gint64 start, guint n)
+{
+    return (gdouble) (g_get_monotonic_time () - start) / n;
+}
+
+/* Anywhere in the data range, or close to the curve in the order of a pointer
+ * following it */
+static void
+make_queries (gdouble *qx, gdouble *qy, gboolean along, guint32 seed)
+{
+    for (guint q = 0; q < N_QUERIES; q++) {
+        if (along) {
+            guint i = (guint) ((guint64) q * n_points / N_QUERIES);
+
+            qx[q] = xs[i] + 0.01 * (random_unit (&seed) - 0.5);
+            qy[q] = ys[i] + 0.01 * (random_unit (&seed) - 0.5);
+        }
+        else {
+            qx[q] = random_unit (&seed);
+            qy[q] = random_unit (&seed);
+        }
+    }
+}
+
+/* Returns the number of results that differ from a brute force scan */
+static guint
+check_queries (EggDataPoints *points, const gdouble *qx, const gdouble *qy, GArray *found)
+{
+    guint    indices[K_NEAREST];
+    gdouble  distances[K_NEAREST];
+    guint    mismatches = 0;
+
+    for (guint q = 0; q < N_QUERIES; q += N_QUERIES / N_CHECKED) {
+        egg_data_points_get_closest_points (points, qx[q], qy[q], 1, indices, distances);
+        mismatches += distances[0] != brute_nearest (qx[q], qy[q]);
+
+        egg_data_points_get_closest_points (points, qx[q], qy[q], K_NEAREST, indices, distances);
+        mismatches += distances[K_NEAREST - 1] != brute_kth (qx[q], qy[q], K_NEAREST);
+
+        g_array_set_size (found, 0);
+        egg_data_points_find_points_in_radius (points, qx[q], qy[q], RADIUS, found);
+        mismatches += found->len != brute_within (qx[q], qy[q], RADIUS);
+    }
+
+    return mismatches;
+}
+
+static void
+time_queries (EggDataPoints *points, const gdouble *qx, const gdouble *qy, GArray *found)
+{
+    guint    indices[K_NEAREST];
+    gdouble  distances[K_NEAREST];
+    guint    checksum = 0;
+    gdouble  nearest, k_nearest, radius;
+    gint64   start;
+
+    start = g_get_monotonic_time ();
+
+    for (guint q = 0; q < N_QUERIES; q++) {
+        egg_data_points_get_closest_points (points, qx[q], qy[q], 1, indices, distances);
+        checksum += indices[0];
+    }
+
+    nearest = elapsed_us (start, N_QUERIES);
+    start = g_get_monotonic_time ();
+
+    for (guint q = 0; q < N_QUERIES; q++) {
+        egg_data_points_get_closest_points (points, qx[q], qy[q], K_NEAREST, indices, distances);
+        checksum += indices[K_NEAREST - 1];
+    }
+
+    k_nearest = elapsed_us (start, N_QUERIES);
+    start = g_get_monotonic_time ();
+
+    for (guint q = 0; q < N_QUERIES; q++) {
+        g_array_set_size (found, 0);
+        egg_data_points_find_points_in_radius (points, qx[q], qy[q], RADIUS, found);
+        checksum += found->len;
+    }
+
+    radius = elapsed_us (start, N_QUERIES);
+
+    g_print ("%8.3f us %8.3f us %8.3f us  (checksum %u)\n",
+             nearest, k_nearest, radius, checksum);
+}
+
+int
+main (int argc, char* argv[])
+{
+    EggDataPoints *points;
+    GArray  *found;
+    gdouble  distance;
+    gdouble *qx, *qy;
+    guint    mismatches = 0;
+    guint32  seed = 1;
+    gint64   start;
+
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+    g_type_init ();
+#endif
+
+    n_points = argc > 1 ? (guint) atoi (argv[1]) : 1000000;
+    n_points = MAX (n_points, K_NEAREST);
+
+    /* A noisy wave over the unit square, sorted by x like a curve */
+    xs = g_new (gdouble, n_points);
+    ys = g_new (gdouble, n_points);
+
+    for (guint i = 0; i < n_points; i++) {
+        xs[i] = (gdouble) i / n_points;
+        ys[i] = 0.5 + 0.3 * sin (20.0 * xs[i]) + 0.05 * (random_unit (&seed) - 0.5);
+    }
+
+    points = egg_data_points_new (0.0, 1.0, 0.0, 1.0);
+    egg_data_points_set_points_from_arrays (points, xs, ys, n_points);
+    found = g_array_new (FALSE, FALSE, sizeof (guint));
+    qx = g_new (gdouble, N_QUERIES);
+    qy = g_new (gdouble, N_QUERIES);
+
+    start = g_get_monotonic_time ();
+    egg_data_get_closest_point (points, 0.5, 0.5, &distance);
+    g_print ("%u points, index built in %.1f ms\n", n_points,
+             (g_get_monotonic_time () - start) / 1000.0);
+
+    g_print ("queries         nearest  %u nearest  radius %.3f\n", K_NEAREST, RADIUS);
+
+    make_queries (qx, qy, TRUE, 2);
+    mismatches += check_queries (points, qx, qy, found);
+    g_print ("along curve  ");
+    time_queries (points, qx, qy, found);
+
+    /* Remove and reinsert points in the middle, so that the following checks
+     * see the indices behind them shifted back and forth */
+    start = g_get_monotonic_time ();
+
+    for (guint e = 0; e < N_EDITS; e++) {
+        guint index = (guint) (random_unit (&seed) * (n_points - 1));
+
+        egg_data_points_remove_point (points, index);
+        egg_data_points_insert_point (points, index, xs[index], ys[index]);
+    }
+
+    g_print ("interior edit %7.3f us\n", elapsed_us (start, 2 * N_EDITS));
+
+    make_queries (qx, qy, FALSE, 3);
+    mismatches += check_queries (points, qx, qy, found);
+    g_print ("anywhere     ");
+    time_queries (points, qx, qy, found);
+
+    start = g_get_monotonic_time ();
+    distance = 0.0;
+
+    for (guint q = 0; q < N_CHECKED; q++)
+        distance += brute_nearest (qx[q], qy[q]);
+
+    g_print ("brute force  %8.3f us  (checksum %f)\n", elapsed_us (start, N_CHECKED), distance);
+
+    g_print ("%u mismatches\n", mismatches);
+
+    g_array_free (found, TRUE);
+    g_object_unref (points);
+    g_free (qx);
+    g_free (qy);
+    g_free (xs);
+    g_free (ys);
+
+    return mismatches > 0 ? 1 : 0;
+}
@@ -36,16 +36,71 @@ on_point_changed (EggPiecewiseLinearView *view, guint index)
              egg_data_points_get_y_value (points, index));
 }
 
+static void
+on_selection_changed (EggPiecewiseLinearView *view)
+{
+    guint n_selected;
+
+    egg_piecewise_linear_view_get_selection (view, &n_selected);
+    g_print ("%u points selected\n", n_selected);
+}
+
+static guint replace_source = 0;
+
+/*
+ * Replace the inner points in one batch without changing their number, by
+ * moving each of them to the back with a slightly different y value. A drag
+ * that is going on at the same time has to stop, the selection loses the
+ * inner points.
+ */
+static gboolean
+replace_points (gpointer user_data)
+{
+    EggDataPoints *points;
+    guint n_points;
+
+    points = egg_piecewise_linear_view_get_points (EGG_PIECEWISE_LINEAR_VIEW (user_data));
+    n_points = egg_data_points_get_num (points);
+
+    egg_data_points_begin_update (points);
+
+    for (guint i = 1; i + 1 < n_points; i++) {
+        gdouble x = egg_data_points_get_x_value (points, 1);
+        gdouble y = egg_data_points_get_y_value (points, 1);
+
+        egg_data_points_remove_point (points, 1);
+        egg_data_points_insert_point (points, n_points - 2, x,
+                                      y + g_random_double_range (-5.0, 5.0));
+    }
+
+    egg_data_points_end_update (points);
+    return TRUE;
+}
+
+static void
+on_replace_toggled (GtkToggleButton *button, GtkWidget *view)
+{
+    if (gtk_toggle_button_get_active (button)) {
+        replace_source = g_timeout_add (500, replace_points, view);
+    }
+    else if (replace_source != 0) {
+        g_source_remove (replace_source);
+        replace_source = 0;
+    }
+}
+
 int
 main (int argc, char* argv[])
 {
     GtkWidget *window;
     GtkWidget *container;
     GtkWidget *view;
+    GtkWidget *scrolled_window;
     GtkWidget *fixed_button_box;
     GtkWidget *fixed_x_button;
     GtkWidget *fixed_y_button;
     GtkWidget *fixed_borders_button;
+    GtkWidget *replace_button;
     GtkWidget *grid_button_box;
     GtkWidget *grid_x_button;
     GtkWidget *grid_y_button;
@@ -73,6 +128,12 @@ main (int argc, char* argv[])
     egg_piecewise_linear_view_set_points (EGG_PIECEWISE_LINEAR_VIEW (view), points);
 
     g_signal_connect (view, "point-changed", G_CALLBACK (on_point_changed), NULL);
+    g_signal_connect (view, "selection-changed", G_CALLBACK (on_selection_changed), NULL);
+
+    scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+    gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window),
+                                    GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_container_add (GTK_CONTAINER (scrolled_window), view);
 
 #if GTK_CHECK_VERSION(3, 2, 0)
     container = gtk_box_new (GTK_ORIENTATION_VERTICAL, 6);
@@ -93,6 +154,10 @@ main (int argc, char* argv[])
     fixed_y_button = gtk_check_button_new_with_label ("Fixed Y");
     fixed_borders_button = gtk_check_button_new_with_label ("Fixed Borders");
 
+    /* Batch replaces to try while dragging */
+    replace_button = gtk_check_button_new_with_label ("Replace Points");
+    g_signal_connect (replace_button, "toggled", G_CALLBACK (on_replace_toggled), view);
+
     /* Create grid buttons */
     grid_x_enable_button = gtk_check_button_new_with_label ("Snap to X");
     grid_y_enable_button = gtk_check_button_new_with_label ("Snap to Y");
@@ -106,13 +171,14 @@ main (int argc, char* argv[])
     gtk_box_pack_start (GTK_BOX (fixed_button_box), fixed_x_button, TRUE, TRUE, 3);
     gtk_box_pack_start (GTK_BOX (fixed_button_box), fixed_y_button, TRUE, TRUE, 3);
     gtk_box_pack_start (GTK_BOX (fixed_button_box), fixed_borders_button, TRUE, TRUE, 3);
+    gtk_box_pack_start (GTK_BOX (fixed_button_box), replace_button, TRUE, TRUE, 3);
 
     gtk_box_pack_start (GTK_BOX (grid_button_box), grid_x_enable_button, TRUE, TRUE, 3);
     gtk_box_pack_start (GTK_BOX (grid_button_box), grid_x_button, TRUE, TRUE, 3);
     gtk_box_pack_start (GTK_BOX (grid_button_box), grid_y_enable_button, TRUE, TRUE, 3);
     gtk_box_pack_start (GTK_BOX (grid_button_box), grid_y_button, TRUE, TRUE, 3);
 
-    gtk_box_pack_start (GTK_BOX (container), view, TRUE, TRUE, 6);
+    gtk_box_pack_start (GTK_BOX (container), scrolled_window, TRUE, TRUE, 6);
     gtk_box_pack_start (GTK_BOX (container), fixed_button_box, FALSE, TRUE, 6);
     gtk_box_pack_start (GTK_BOX (container), grid_button_box, FALSE, TRUE, 6);
 